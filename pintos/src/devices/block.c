@@ -4,6 +4,7 @@
 #include <string.h>
 #include "devices/ide.h"
 #include "threads/malloc.h"
+#include "threads/trace.h"
 
 /* A block device. */
 struct block {
@@ -97,7 +98,9 @@ static void check_sector(struct block *block, block_sector_t sector) {
    per-block device locking is unneeded. */
 void block_read(struct block *block, block_sector_t sector, void *buffer) {
     check_sector(block, sector);
+    TRACE(BLOCK_READ, block->type, sector, 0);
     block->ops->read(block->aux, sector, buffer);
+    TRACE(BLOCK_DONE, block->type, sector, 0);
     block->read_cnt++;
 }
 
@@ -110,7 +113,9 @@ void block_write(struct block *block, block_sector_t sector,
                  const void *buffer) {
     check_sector(block, sector);
     ASSERT(block->type != BLOCK_FOREIGN);
+    TRACE(BLOCK_WRITE, block->type, sector, 0);
     block->ops->write(block->aux, sector, buffer);
+    TRACE(BLOCK_DONE, block->type, sector, 0);
     block->write_cnt++;
 }
 
@@ -123,6 +128,12 @@ const char *block_name(struct block *block) { return block->name; }
 /* Returns BLOCK's type. */
 enum block_type block_type(struct block *block) { return block->type; }
 
+/* Returns the number of sectors read from BLOCK since boot. */
+unsigned long long block_read_cnt(struct block *block) { return block->read_cnt; }
+
+/* Returns the number of sectors written to BLOCK since boot. */
+unsigned long long block_write_cnt(struct block *block) { return block->write_cnt; }
+
 /* Prints statistics for each block device used for a Pintos role. */
 void block_print_stats(void) {
     int i;
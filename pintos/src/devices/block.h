@@ -56,6 +56,8 @@ const char *block_name(struct block *);
 enum block_type block_type(struct block *);
 
 /* Statistics. */
+unsigned long long block_read_cnt(struct block *);
+unsigned long long block_write_cnt(struct block *);
 void block_print_stats(void);
 
 /* Lower-level interface to block device drivers. */
@@ -41,6 +41,36 @@ input_getc (void)
   return key;
 }
 
+/* Retrieves up to SIZE keys from the input buffer into KEYS,
+   stopping after a new-line or carriage return.  If the buffer
+   is empty, waits for a key to be pressed, then takes whatever
+   else has already arrived without waiting further.  Returns the
+   number of keys retrieved, which is at least 1 unless SIZE is
+   0. */
+size_t
+input_getbuf (uint8_t *keys, size_t size)
+{
+  enum intr_level old_level;
+  size_t cnt = 0;
+
+  if (size == 0)
+    return 0;
+
+  old_level = intr_disable ();
+  do
+    {
+      uint8_t key = intq_getc (&buffer);
+      keys[cnt++] = key;
+      if (key == '\n' || key == '\r')
+        break;
+    }
+  while (cnt < size && !intq_empty (&buffer));
+  serial_notify ();
+  intr_set_level (old_level);
+
+  return cnt;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
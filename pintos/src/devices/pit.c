@@ -11,9 +11,6 @@
 #define PIT_PORT_CONTROL          0x43                /* Control port. */
 #define PIT_PORT_COUNTER(CHANNEL) (0x40 + (CHANNEL))  /* Counter port. */
 
-/* PIT cycles per second. */
-#define PIT_HZ 1193180
-
 /* Configure the given CHANNEL in the PIT.  In a PC, the PIT's
    three output channels are hooked up like this:
 
@@ -81,3 +78,73 @@ pit_configure_channel (int channel, int mode, int frequency)
   outb (PIT_PORT_COUNTER (channel), count >> 8);
   intr_set_level (old_level);
 }
+
+/* Starts CHANNEL counting down COUNT PIT cycles in mode 0,
+   "interrupt on terminal count."  For channel 0 this raises a
+   single timer interrupt after COUNT / PIT_HZ seconds.  After
+   reaching zero the counter keeps counting down, wrapping around
+   to 0xffff, so pit_read_counter() can still measure how long ago
+   the interrupt was raised, and pit_read_back() can tell whether
+   it was raised at all.
+
+   COUNT must be between 1 and 65535. */
+void
+pit_start_oneshot (int channel, unsigned count)
+{
+  enum intr_level old_level;
+
+  ASSERT (channel == 0 || channel == 2);
+  ASSERT (count >= 1 && count <= 0xffff);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30);
+  outb (PIT_PORT_COUNTER (channel), count);
+  outb (PIT_PORT_COUNTER (channel), count >> 8);
+  intr_set_level (old_level);
+}
+
+/* Returns the current value of CHANNEL's 16-bit down-counter.
+   Uses the counter latch command so that the two bytes are read
+   consistently. */
+unsigned
+pit_read_counter (int channel)
+{
+  enum intr_level old_level;
+  unsigned count;
+
+  ASSERT (channel >= 0 && channel <= 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, channel << 6);
+  count = inb (PIT_PORT_COUNTER (channel));
+  count |= inb (PIT_PORT_COUNTER (channel)) << 8;
+  intr_set_level (old_level);
+
+  return count;
+}
+
+/* Latches CHANNEL's status byte and counter together with the
+   8254 read-back command, stores the counter in *COUNT, and
+   returns the status.  PIT_STATUS_OUTPUT in the status is the
+   level of the channel's output, which for a one-shot started by
+   pit_start_oneshot() goes high when the count reaches zero and
+   stays high.  PIT_STATUS_NULL_COUNT means that a newly written
+   count has not been loaded into the counter yet, so *COUNT is
+   not meaningful. */
+unsigned
+pit_read_back (int channel, unsigned *count)
+{
+  enum intr_level old_level;
+  unsigned status;
+
+  ASSERT (channel >= 0 && channel <= 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, 0xc0 | (2 << channel));
+  status = inb (PIT_PORT_COUNTER (channel));
+  *count = inb (PIT_PORT_COUNTER (channel));
+  *count |= inb (PIT_PORT_COUNTER (channel)) << 8;
+  intr_set_level (old_level);
+
+  return status;
+}
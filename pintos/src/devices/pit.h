@@ -3,6 +3,17 @@
 
 #include <stdint.h>
 
+/* PIT cycles per second. */
+#define PIT_HZ 1193180
+
 void pit_configure_channel (int channel, int mode, int frequency);
+void pit_start_oneshot (int channel, unsigned count);
+unsigned pit_read_counter (int channel);
+
+/* Bits in the status returned by pit_read_back(). */
+#define PIT_STATUS_OUTPUT 0x80     /* Output pin is high. */
+#define PIT_STATUS_NULL_COUNT 0x40 /* New count not loaded yet. */
+
+unsigned pit_read_back (int channel, unsigned *count);
 
 #endif /* devices/pit.h */
@@ -129,6 +129,44 @@ void serial_putc(uint8_t byte)
   intr_set_level(old_level);
 }
 
+/* Sends the N bytes in BUFFER to the serial port.  Equivalent to
+   calling serial_putc() on each byte, but disables interrupts
+   and updates the interrupt enable register only once for the
+   whole run, unless the transmit queue fills up. */
+void serial_putbuf(const uint8_t *buffer, size_t n)
+{
+  enum intr_level old_level = intr_disable();
+
+  if (mode != QUEUE)
+  {
+    if (mode == UNINIT)
+      init_poll();
+    while (n-- > 0)
+      putc_poll(*buffer++);
+  }
+  else
+  {
+    while (n-- > 0)
+    {
+      if (intq_full(&txq))
+      {
+        /* Same as in serial_putc(): poll a byte out if we
+           may not sleep, otherwise make sure the transmit
+           interrupt is enabled before intq_putc() waits for
+           it to drain the queue. */
+        if (old_level == INTR_OFF)
+          putc_poll(intq_getc(&txq));
+        else
+          write_ier();
+      }
+      intq_putc(&txq, *buffer++);
+    }
+    write_ier();
+  }
+
+  intr_set_level(old_level);
+}
+
 /* Flushes anything in the serial buffer out the port in polling
    mode. */
 void serial_flush(void)
@@ -5,7 +5,13 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "threads/io.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/profile.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #endif
@@ -123,6 +129,11 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  profile_print ();
+  kmem_print_stats ();
+  malloc_print_stats ();
+  lock_print_stats ();
+  palloc_print_stats ();
 #ifdef FILESYS
   block_print_stats ();
 #endif
@@ -131,4 +142,5 @@ print_stats (void)
 #ifdef USERPROG
   exception_print_stats ();
 #endif
+  trace_dump ();
 }
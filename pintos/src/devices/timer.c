@@ -5,8 +5,10 @@
 #include <stdio.h>
 #include "devices/pit.h"
 #include "threads/interrupt.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/tsc.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -24,11 +26,92 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
-/* List to store currently sleeping threads*/
-static struct list nap_room;
+/* Time-stamp counter rate, in cycles per second, and a reading
+   of it taken TSC_BASE_NS nanoseconds after boot.  Initialized
+   by timer_calibrate(); until then tsc_hz is 0 and timer_ns()
+   falls back to the PIT. */
+static uint64_t tsc_hz;
+static uint64_t tsc_base;
+static int64_t tsc_base_ns;
+
+/* Pending timer events are kept in a hierarchical timer wheel.
+   Level 0 has one slot per tick for the next WHEEL_SIZE ticks;
+   each slot of level L covers WHEEL_SIZE^L ticks.  An event is
+   filed in the lowest level whose range covers its expiry, which
+   makes insertion and removal constant time.  Whenever the level
+   0 index wraps, the current slot of the next level up is
+   "cascaded", that is, its events are refiled at lower levels,
+   so each event is moved at most WHEEL_LEVELS times before it
+   fires.  Events too far in the future for the top level wait
+   on wheel_overflow until the top level wraps. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static struct list wheel_overflow;
+
+/* Next tick whose level 0 slot has not yet been run. */
+static int64_t wheel_time;
+
+/* PIT cycles per timer tick. */
+#define CYCLES_PER_TICK ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest one-shot count we program, the most the 16-bit counter
+   holds (about 55 ms).  The idle thread may sleep for longer: the
+   interrupt handler then re-arms one-shots back to back until
+   idle_deadline.  clock_now() tells a counter that has wrapped past
+   zero from one that is still counting by the PIT's output pin. */
+#define ONESHOT_MAX 0xffff
+
+/* Sub-tick sleeps shorter than this many PIT cycles (about 100
+   us) still busy-wait, since blocking and reprogramming the PIT
+   would take longer than the sleep itself. */
+#define HRSLEEP_MIN_CYCLES (PIT_HZ / 10000)
+
+/* Clock state.  Time is measured in PIT cycles since boot.
+   Normally channel 0 runs periodically and each interrupt is one
+   tick.  When the idle thread halts with no timer event due in
+   the next tick, or a thread asks for a sub-tick sleep, the PIT
+   is switched to one-shot mode and programmed for the exact
+   deadline, and the interrupt handler counts the tick boundaries
+   that passed in the meantime.  Ticks that pass while the idle
+   thread is halted are charged to it.  Once nothing needs
+   one-shot mode, the handler switches back to periodic
+   interrupts. */
+static bool oneshot;            /* Channel 0 in one-shot mode? */
+static int64_t clock_base;      /* Time of last periodic interrupt,
+                                   or when the one-shot was armed. */
+static unsigned oneshot_count;  /* Cycles programmed for one-shot. */
+static int64_t clock_last;      /* Keeps clock_now() monotonic. */
+static int64_t next_tick_time;  /* Time at which ticks advances. */
+static bool idle_skipping;      /* Idle thread halted, tick off? */
+static int64_t idle_deadline;   /* Latest time to wake idle. */
+static int64_t skipped_ticks;   /* Ticks with no interrupt of their own. */
+
+/* A thread in a sub-tick sleep. */
+struct hires_sleeper
+{
+	int64_t deadline;      /* Time to wake up, in PIT cycles. */
+	struct thread *thread; /* Sleeping thread. */
+	struct list_elem elem; /* Element in hires_sleepers. */
+};
+
+/* Sub-tick sleepers, ordered by deadline. */
+static struct list hires_sleepers;
 
 static intr_handler_func timer_interrupt;
+static void wheel_insert(struct timer_event *);
+static void wheel_cascade(struct list *);
+static void wheel_advance(int64_t now);
+static timer_func wake_thread;
+static int64_t clock_now(void);
+static void clock_catch_up(int64_t now, bool periodic);
+static void clock_program(int64_t now, bool in_handler);
+static void hires_wake(int64_t now);
+static void hires_sleep(int64_t cycles);
 static bool too_many_loops(unsigned loops);
+static void calibrate_tsc(void);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
 static void real_time_delay(int64_t num, int32_t denom);
@@ -37,10 +120,19 @@ static void real_time_delay(int64_t num, int32_t denom);
    and registers the corresponding interrupt. */
 void timer_init(void)
 {
+	int level, slot;
+
 	pit_configure_channel(0, 2, TIMER_FREQ);
 	intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 
-	list_init(&nap_room);
+	for (level = 0; level < WHEEL_LEVELS; level++)
+		for (slot = 0; slot < WHEEL_SIZE; slot++)
+			list_init(&wheel[level][slot]);
+	list_init(&wheel_overflow);
+	wheel_time = 0;
+
+	list_init(&hires_sleepers);
+	next_tick_time = CYCLES_PER_TICK;
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -66,7 +158,39 @@ void timer_calibrate(void)
 		if (!too_many_loops(high_bit | test_bit))
 			loops_per_tick |= test_bit;
 
-	printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+	printf("%'" PRIu64 " loops/s", (uint64_t)loops_per_tick * TIMER_FREQ);
+
+	calibrate_tsc();
+	printf(", %'" PRIu64 " TSC cycles/s.\n", tsc_hz);
+}
+
+/* Measures the rate of the time-stamp counter against the PIT
+   over a couple of timer ticks, the same way loops_per_tick is
+   calibrated, but reading the PIT counter for sub-tick
+   precision at both ends. */
+static void
+calibrate_tsc(void)
+{
+	enum intr_level old_level;
+	int64_t pit_start, pit_end, start;
+	uint64_t tsc_start, tsc_end;
+
+	old_level = intr_disable();
+	pit_start = clock_now();
+	tsc_start = rdtsc();
+	intr_set_level(old_level);
+
+	start = timer_ticks();
+	while (timer_ticks() - start < 2)
+		barrier();
+
+	old_level = intr_disable();
+	pit_end = clock_now();
+	tsc_end = rdtsc();
+	tsc_base_ns = pit_end * 1000000000 / PIT_HZ;
+	tsc_base = tsc_end;
+	tsc_hz = (tsc_end - tsc_start) * PIT_HZ / (pit_end - pit_start);
+	intr_set_level(old_level);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -75,6 +199,16 @@ timer_ticks(void)
 {
 	enum intr_level old_level = intr_disable();
 	int64_t t = ticks;
+
+	/* While the idle thread is halted with the tick stopped, ticks
+	   only catches up when a one-shot fires, so count the tick
+	   boundaries passed since then from the PIT. */
+	if (idle_skipping)
+	{
+		int64_t now = clock_now();
+		if (now >= next_tick_time)
+			t += (now - next_tick_time) / CYCLES_PER_TICK + 1;
+	}
 	intr_set_level(old_level);
 	return t;
 }
@@ -87,32 +221,130 @@ timer_elapsed(int64_t then)
 	return timer_ticks() - then;
 }
 
-/* Compares two thead wake up times */
-static bool
-thread_less(const struct list_elem *a_, const struct list_elem *b_,
-			void *aux UNUSED)
+/* Returns the number of nanoseconds since the OS booted.
+   Resolution is one TSC cycle after timer_calibrate(), one PIT
+   cycle (about 838 ns) before. */
+int64_t
+timer_ns(void)
 {
-	const struct thread *a = list_entry(a_, struct thread, nap_elem);
-	const struct thread *b = list_entry(b_, struct thread, nap_elem);
+	enum intr_level old_level;
+	int64_t ns;
 
-	return a->wake_up_tick < b->wake_up_tick;
+	if (tsc_hz != 0)
+		return tsc_base_ns + timer_tsc_to_ns(rdtsc() - tsc_base);
+
+	old_level = intr_disable();
+	ns = clock_now() * 1000000000 / PIT_HZ;
+	intr_set_level(old_level);
+	return ns;
+}
+
+/* Converts CYCLES, a difference between two rdtsc() readings,
+   into nanoseconds.  Returns 0 before timer_calibrate(). */
+int64_t
+timer_tsc_to_ns(uint64_t cycles)
+{
+	if (tsc_hz == 0)
+		return 0;
+
+	/* Split to keep CYCLES * 10^9 from overflowing. */
+	return cycles / tsc_hz * 1000000000
+		   + cycles % tsc_hz * 1000000000 / tsc_hz;
+}
+
+/* Initializes EVENT to call FUNC, passing AUX, when it expires.
+   The event is not scheduled until passed to timer_event_add(). */
+void timer_event_init(struct timer_event *event, timer_func *func, void *aux)
+{
+	ASSERT(event != NULL);
+	ASSERT(func != NULL);
+
+	event->func = func;
+	event->aux = aux;
+	event->expires = 0;
+	event->pending = false;
+}
+
+/* Schedules EVENT to fire at the first timer interrupt at which
+   timer_ticks() >= EXPIRES.  If EXPIRES has already passed, the
+   event fires at the next timer interrupt.  EVENT must not
+   already be pending.
+
+   The event's function runs in the timer interrupt handler, so it
+   must not sleep and should finish quickly.  An event may re-add
+   itself from its own function.
+
+   This function may be called from an interrupt handler. */
+void timer_event_add(struct timer_event *event, int64_t expires)
+{
+	enum intr_level old_level;
+
+	ASSERT(event != NULL);
+
+	old_level = intr_disable();
+	ASSERT(!event->pending);
+	event->expires = expires;
+	event->pending = true;
+	wheel_insert(event);
+
+	/* An interrupt handler may add an event while the idle thread
+	   is halted with the tick stopped until a later time. */
+	if (idle_skipping)
+	{
+		int64_t time = next_tick_time + (expires - ticks - 1) * CYCLES_PER_TICK;
+		if (time < idle_deadline)
+		{
+			idle_deadline = time;
+			clock_program(clock_now(), false);
+		}
+	}
+	intr_set_level(old_level);
+}
+
+/* Cancels EVENT if it has not fired yet.  Returns true if EVENT
+   was pending, false if it had already fired or was never added.
+
+   This function may be called from an interrupt handler. */
+bool timer_event_cancel(struct timer_event *event)
+{
+	enum intr_level old_level;
+	bool was_pending;
+
+	ASSERT(event != NULL);
+
+	old_level = intr_disable();
+	was_pending = event->pending;
+	if (was_pending)
+	{
+		list_remove(&event->elem);
+		event->pending = false;
+	}
+	intr_set_level(old_level);
+
+	return was_pending;
+}
+
+/* Timer event function that unblocks the sleeping thread T. */
+static void
+wake_thread(void *t)
+{
+	thread_unblock(t);
 }
 
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
    be turned on. */
 void timer_sleep(int64_t ticks)
 {
+	struct timer_event wake;
+	enum intr_level old_level;
 
-	struct thread *curr = thread_current();
 	ASSERT(intr_get_level() == INTR_ON);
 
-	curr->wake_up_tick = timer_ticks() + ticks;
-
-	enum intr_level old_level = intr_disable();
+	timer_event_init(&wake, wake_thread, thread_current());
 
-	list_insert_ordered(&nap_room, &curr->nap_elem, thread_less, NULL);
+	old_level = intr_disable();
+	timer_event_add(&wake, timer_ticks() + ticks);
 	thread_block();
-
 	intr_set_level(old_level);
 }
 
@@ -177,30 +409,333 @@ void timer_ndelay(int64_t ns)
 void timer_print_stats(void)
 {
 	printf("Timer: %" PRId64 " ticks\n", timer_ticks());
+	printf("Timer: %" PRId64 " ticks elapsed without an interrupt\n",
+		   skipped_ticks);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  If no timer event is due at the next tick, stops the
+   periodic tick until the first tick that has work, with a chain
+   of one-shot interrupts if that is further ahead than the PIT can
+   count.  Does nothing if the tick is already stopped. */
+void timer_idle_enter(void)
+{
+	int64_t tick;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (idle_skipping)
+		return;
+
+	/* Stop at a cascade boundary too, since events at higher
+	   levels of the wheel may become due there. */
+	for (tick = ticks + 1; (tick & WHEEL_MASK) != 0; tick++)
+		if (!list_empty(&wheel[0][tick & WHEEL_MASK]))
+			break;
+	if (tick == ticks + 1)
+		return;
+
+	idle_skipping = true;
+	idle_deadline = next_tick_time + (tick - ticks - 1) * CYCLES_PER_TICK;
+	clock_program(clock_now(), false);
+}
+
+/* Called by the idle thread, with interrupts off, after it wakes
+   up and before it lets another thread run.  If the periodic
+   tick was stopped, accounts for the ticks that elapsed and runs
+   any timer events that came due. */
+void timer_idle_exit(void)
+{
+	int64_t now;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!idle_skipping)
+		return;
+
+	idle_skipping = false;
+	now = clock_now();
+	clock_catch_up(now, false);
+	hires_wake(now);
+	clock_program(now, false);
 }
 
 /* Timer interrupt handler. */
 static void
-timer_interrupt(struct intr_frame *args UNUSED)
+timer_interrupt(struct intr_frame *args)
 {
-	ticks++;
+	int64_t now;
 
-	while (!list_empty(&nap_room))
+	if (profile_enabled)
+		profile_sample(args);
+
+	if (!oneshot)
 	{
-		struct thread *head_thread = list_entry(list_begin(&nap_room), struct thread, nap_elem);
+		/* Periodic mode: exactly one tick has passed. */
+		now = clock_base += CYCLES_PER_TICK;
+		if (now > clock_last)
+			clock_last = now;
+		clock_catch_up(now, true);
+		if (list_empty(&hires_sleepers))
+			return;
+	}
+	else
+	{
+		/* While the idle thread is halted this may be one link in
+		   a chain of one-shots: the ticks that passed were idle,
+		   and the tick stays stopped until idle_deadline. */
+		bool idle = idle_skipping;
+
+		now = clock_now();
+		idle_skipping = false;
+		clock_catch_up(now, !idle);
+		if (idle && now < idle_deadline)
+			idle_skipping = true;
+	}
 
-		if (head_thread->wake_up_tick <= ticks)
-		{
-			list_pop_front(&nap_room);
-			thread_unblock(head_thread);
-		}
+	hires_wake(now);
+	clock_program(now, true);
+}
+
+/* Returns the current time in PIT cycles since boot.  Interrupts
+   must be off. */
+static int64_t
+clock_now(void)
+{
+	unsigned counter, status;
+	int64_t now;
+
+	if (!oneshot)
+	{
+		counter = pit_read_counter(0);
+		now = clock_base + CYCLES_PER_TICK
+			  - (counter < CYCLES_PER_TICK ? counter : CYCLES_PER_TICK);
+	}
+	else
+	{
+		status = pit_read_back(0, &counter);
+		if (status & PIT_STATUS_NULL_COUNT)
+			now = clock_base;
+		else if (!(status & PIT_STATUS_OUTPUT))
+			now = clock_base + (oneshot_count - counter);
 		else
+			now = clock_base + oneshot_count + ((0x10000 - counter) & 0xffff);
+	}
+
+	/* In periodic mode the counter reloads before a delayed
+	   interrupt is handled, which would make time jump back. */
+	if (now < clock_last)
+		now = clock_last;
+	clock_last = now;
+	return now;
+}
+
+/* Advances ticks past every tick boundary at or before NOW,
+   running due timer events and the scheduler's tick accounting
+   for each.  PERIODIC is true when called from the timer
+   interrupt handler for the running thread's tick, which
+   thread_tick() charges to it.  Otherwise the ticks passed with
+   the idle thread halted and go to thread_idle_tick(). */
+static void
+clock_catch_up(int64_t now, bool periodic)
+{
+	int crossed = 0;
+
+	while (now >= next_tick_time)
+	{
+		next_tick_time += CYCLES_PER_TICK;
+		ticks++;
+		crossed++;
+		wheel_advance(ticks);
+		if (periodic)
+			thread_tick();
+		else
+			thread_idle_tick();
+	}
+
+	if (crossed > (periodic ? 1 : 0))
+		skipped_ticks += crossed - (periodic ? 1 : 0);
+}
+
+/* Programs channel 0 for the next interrupt the system needs,
+   given that the time is NOW: the next tick boundary, an earlier
+   sub-tick sleeper, or, while the idle thread is halted, the
+   later idle_deadline.  Returning to periodic mode is only done
+   from the interrupt handler (IN_HANDLER), since elsewhere a
+   one-shot interrupt could already be pending and would then be
+   mistaken for a periodic tick. */
+static void
+clock_program(int64_t now, bool in_handler)
+{
+	int64_t deadline = idle_skipping ? idle_deadline : next_tick_time;
+	int64_t delta;
+
+	if (!list_empty(&hires_sleepers))
+	{
+		struct hires_sleeper *s =
+			list_entry(list_front(&hires_sleepers), struct hires_sleeper, elem);
+		if (s->deadline < deadline)
+			deadline = s->deadline;
+	}
+
+	if (deadline == next_tick_time && !idle_skipping)
+	{
+		/* Only the regular tick is needed. */
+		if (!oneshot)
+			return;
+		if (in_handler && next_tick_time - now >= CYCLES_PER_TICK - CYCLES_PER_TICK / 8)
 		{
-			break;
+			/* We are just past a tick boundary: resume periodic
+			   interrupts with (nearly) the original phase. */
+			pit_configure_channel(0, 2, TIMER_FREQ);
+			oneshot = false;
+			clock_base = now;
+			return;
 		}
 	}
 
-	thread_tick();
+	delta = deadline - now;
+	if (delta < 1)
+		delta = 1;
+	else if (delta > ONESHOT_MAX)
+		delta = ONESHOT_MAX;
+	pit_start_oneshot(0, delta);
+	oneshot = true;
+	clock_base = now;
+	oneshot_count = delta;
+}
+
+/* Returns true if sub-tick sleeper A wakes before B. */
+static bool
+hires_less(const struct list_elem *a_, const struct list_elem *b_,
+		   void *aux UNUSED)
+{
+	const struct hires_sleeper *a = list_entry(a_, struct hires_sleeper, elem);
+	const struct hires_sleeper *b = list_entry(b_, struct hires_sleeper, elem);
+
+	return a->deadline < b->deadline;
+}
+
+/* Wakes every sub-tick sleeper whose deadline is at or before
+   NOW. */
+static void
+hires_wake(int64_t now)
+{
+	while (!list_empty(&hires_sleepers))
+	{
+		struct hires_sleeper *s =
+			list_entry(list_front(&hires_sleepers), struct hires_sleeper, elem);
+		if (s->deadline > now)
+			break;
+		list_pop_front(&hires_sleepers);
+		thread_unblock(s->thread);
+	}
+}
+
+/* Blocks the current thread for CYCLES PIT cycles, programming
+   a one-shot interrupt for the deadline if it falls before the
+   next tick.  Interrupts must be on. */
+static void
+hires_sleep(int64_t cycles)
+{
+	struct hires_sleeper s;
+	enum intr_level old_level;
+	int64_t now;
+
+	ASSERT(intr_get_level() == INTR_ON);
+
+	old_level = intr_disable();
+	now = clock_now();
+	s.deadline = now + cycles;
+	s.thread = thread_current();
+	list_insert_ordered(&hires_sleepers, &s.elem, hires_less, NULL);
+	clock_program(now, false);
+	thread_block();
+	intr_set_level(old_level);
+}
+
+/* Files pending EVENT in the timer wheel slot that covers its
+   expiry.  Interrupts must be off. */
+static void
+wheel_insert(struct timer_event *event)
+{
+	int64_t delta = event->expires - wheel_time;
+	int level;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	/* Already due: run it with the next slot. */
+	if (delta < 0)
+	{
+		list_push_back(&wheel[0][wheel_time & WHEEL_MASK], &event->elem);
+		return;
+	}
+
+	for (level = 0; level < WHEEL_LEVELS; level++)
+		if (delta < (int64_t)1 << (WHEEL_BITS * (level + 1)))
+		{
+			int slot = (event->expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+			list_push_back(&wheel[level][slot], &event->elem);
+			return;
+		}
+
+	list_push_back(&wheel_overflow, &event->elem);
+}
+
+/* Refiles every event on LIST relative to the current
+   wheel_time. */
+static void
+wheel_cascade(struct list *list)
+{
+	struct list pending;
+
+	list_init(&pending);
+	list_splice(list_end(&pending), list_begin(list), list_end(list));
+	while (!list_empty(&pending))
+		wheel_insert(list_entry(list_pop_front(&pending), struct timer_event, elem));
+}
+
+/* Runs every event that expires at or before NOW, cascading
+   higher levels of the wheel as their slots come due. */
+static void
+wheel_advance(int64_t now)
+{
+	while (wheel_time <= now)
+	{
+		int slot = wheel_time & WHEEL_MASK;
+		struct list due;
+
+		/* When level L-1 wraps around, pull down level L. */
+		if (slot == 0)
+		{
+			int level;
+
+			for (level = 1; level < WHEEL_LEVELS; level++)
+			{
+				int idx = (wheel_time >> (WHEEL_BITS * level)) & WHEEL_MASK;
+				wheel_cascade(&wheel[level][idx]);
+				if (idx != 0)
+					break;
+			}
+			if (level == WHEEL_LEVELS)
+				wheel_cascade(&wheel_overflow);
+		}
+
+		/* Detach the due events first so that an event re-added
+		   from its own function waits for a later tick. */
+		list_init(&due);
+		list_splice(list_end(&due), list_begin(&wheel[0][slot]),
+					list_end(&wheel[0][slot]));
+		wheel_time++;
+
+		while (!list_empty(&due))
+		{
+			struct timer_event *e =
+				list_entry(list_pop_front(&due), struct timer_event, elem);
+			e->pending = false;
+			e->func(e->aux);
+		}
+	}
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -247,8 +782,12 @@ real_time_sleep(int64_t num, int32_t denom)
      1 s / TIMER_FREQ ticks
   */
 	int64_t ticks = num * TIMER_FREQ / denom;
+	int64_t cycles;
 
 	ASSERT(intr_get_level() == INTR_ON);
+	ASSERT(denom % 1000 == 0);
+	cycles = num * (PIT_HZ / 1000) / (denom / 1000);
+
 	if (ticks > 0)
 	{
 		/* We're waiting for at least one full timer tick.  Use
@@ -256,6 +795,12 @@ real_time_sleep(int64_t num, int32_t denom)
          processes. */
 		timer_sleep(ticks);
 	}
+	else if (cycles >= HRSLEEP_MIN_CYCLES)
+	{
+		/* Sub-tick, but long enough to be worth blocking on a
+         one-shot PIT interrupt instead of spinning. */
+		hires_sleep(cycles);
+	}
 	else
 	{
 		/* Otherwise, use a busy-wait loop for more accurate
@@ -271,5 +816,15 @@ real_time_delay(int64_t num, int32_t denom)
 	/* Scale the numerator and denominator down by 1000 to avoid
      the possibility of overflow. */
 	ASSERT(denom % 1000 == 0);
-	busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+	if (tsc_hz != 0)
+	{
+		/* Spin on the TSC, which unlike a loop count does not
+		   depend on how the loop was compiled or interrupted. */
+		uint64_t start = rdtsc();
+		uint64_t cycles = tsc_hz / 1000 * num / (denom / 1000);
+		while (rdtsc() - start < cycles)
+			barrier();
+	}
+	else
+		busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 }
@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -13,17 +15,45 @@ void timer_calibrate(void);
 int64_t timer_ticks(void);
 int64_t timer_elapsed(int64_t);
 
+/* High-resolution monotonic clock, based on the time-stamp
+   counter once timer_calibrate() has measured its rate. */
+int64_t timer_ns(void);
+int64_t timer_tsc_to_ns(uint64_t cycles);
+
 /* Sleep and yield the CPU to other threads. */
 void timer_sleep(int64_t ticks);
 void timer_msleep(int64_t milliseconds);
 void timer_usleep(int64_t microseconds);
 void timer_nsleep(int64_t nanoseconds);
 
+/* Kernel timer events.  A subsystem that needs a callback at a
+   future tick (a flusher, a read-ahead deadline, a timeout)
+   embeds a struct timer_event and schedules it with
+   timer_event_add().  The callback runs in the timer interrupt. */
+typedef void timer_func(void *aux);
+
+struct timer_event
+{
+	int64_t expires;       /* Tick at which to fire. */
+	timer_func *func;      /* Function to call. */
+	void *aux;             /* Argument for FUNC. */
+	bool pending;          /* Scheduled but not yet fired? */
+	struct list_elem elem; /* Element in a timer wheel slot. */
+};
+
+void timer_event_init(struct timer_event *, timer_func *, void *aux);
+void timer_event_add(struct timer_event *, int64_t expires);
+bool timer_event_cancel(struct timer_event *);
+
 /* Busy waits. */
 void timer_mdelay(int64_t milliseconds);
 void timer_udelay(int64_t microseconds);
 void timer_ndelay(int64_t nanoseconds);
 
+/* Tickless idle, used by the idle thread. */
+void timer_idle_enter(void);
+void timer_idle_exit(void);
+
 void timer_print_stats(void);
 
 #endif /* devices/timer.h */
@@ -31,6 +31,7 @@ static void cls (void);
 static void newline (void);
 static void move_cursor (void);
 static void find_cursor (size_t *x, size_t *y);
+static void putc_raw (int c, enum intr_level old_level);
 
 /* Initializes the VGA text display. */
 static void
@@ -56,7 +57,49 @@ vga_putc (int c)
   enum intr_level old_level = intr_disable ();
 
   init ();
+  putc_raw (c, old_level);
 
+  /* Update cursor position. */
+  move_cursor ();
+
+  intr_set_level (old_level);
+}
+
+/* Maximum number of characters that vga_putbuf() draws with
+   interrupts disabled.  Scrolling the screen costs a few
+   microseconds per line, so this keeps interrupt latency
+   bounded no matter how large the buffer is. */
+#define PUTBUF_CHUNK 256
+
+/* Writes the N characters in BUFFER to the VGA text display, as
+   if by vga_putc(), but moves the hardware cursor only once at
+   the end.  Interrupts are re-enabled between chunks of
+   PUTBUF_CHUNK characters. */
+void
+vga_putbuf (const char *buffer, size_t n)
+{
+  while (n > 0)
+    {
+      size_t chunk = n < PUTBUF_CHUNK ? n : PUTBUF_CHUNK;
+      enum intr_level old_level = intr_disable ();
+
+      init ();
+      n -= chunk;
+      while (chunk-- > 0)
+        putc_raw (*buffer++, old_level);
+      if (n == 0)
+        move_cursor ();
+
+      intr_set_level (old_level);
+    }
+}
+
+/* Writes C to the VGA text display without moving the hardware
+   cursor.  Interrupts must be off; OLD_LEVEL is the level to
+   restore them to while beeping. */
+static void
+putc_raw (int c, enum intr_level old_level)
+{
   switch (c)
     {
     case '\n':
@@ -95,11 +138,6 @@ vga_putc (int c)
         newline ();
       break;
     }
-
-  /* Update cursor position. */
-  move_cursor ();
-
-  intr_set_level (old_level);
 }
 
 /* Clears the screen and moves the cursor to the upper left. */
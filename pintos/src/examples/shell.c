@@ -5,6 +5,8 @@
 
 static void read_line (char line[], size_t);
 static bool backspace (char **pos, char line[]);
+static void run_pipeline (char *left, char *right);
+static char *trim (char *);
 
 int
 main (void)
@@ -30,6 +32,12 @@ main (void)
         {
           /* Empty command. */
         }
+      else if (strchr (command, '|') != NULL)
+        {
+          char *bar = strchr (command, '|');
+          *bar = '\0';
+          run_pipeline (trim (command), trim (bar + 1));
+        }
       else
         {
           pid_t pid = exec (command);
@@ -44,6 +52,59 @@ main (void)
   return EXIT_SUCCESS;
 }
 
+/* Runs LEFT with its standard output connected through a pipe to
+   the standard input of RIGHT, and waits for both. */
+static void
+run_pipeline (char *left, char *right)
+{
+  pid_t left_pid, right_pid;
+  int fds[2];
+
+  if (pipe (fds) < 0)
+    {
+      printf ("pipe failed\n");
+      return;
+    }
+
+  /* Each child inherits our pipe ends, and takes the one we have
+     moved onto its stdin or stdout.  Close the write end before
+     starting RIGHT so that RIGHT sees end of file once LEFT
+     exits. */
+  dup2 (fds[1], STDOUT_FILENO);
+  left_pid = exec (left);
+  close (STDOUT_FILENO);
+  close (fds[1]);
+
+  dup2 (fds[0], STDIN_FILENO);
+  right_pid = exec (right);
+  close (STDIN_FILENO);
+  close (fds[0]);
+
+  if (left_pid != PID_ERROR)
+    printf ("\"%s\": exit code %d\n", left, wait (left_pid));
+  else
+    printf ("\"%s\": exec failed\n", left);
+  if (right_pid != PID_ERROR)
+    printf ("\"%s\": exit code %d\n", right, wait (right_pid));
+  else
+    printf ("\"%s\": exec failed\n", right);
+}
+
+/* Removes leading and trailing spaces from S in place and returns
+   the result. */
+static char *
+trim (char *s)
+{
+  char *end;
+
+  while (*s == ' ')
+    s++;
+  end = s + strlen (s);
+  while (end > s && end[-1] == ' ')
+    *--end = '\0';
+  return s;
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
@@ -55,6 +116,10 @@ read_line (char line[], size_t size)
   for (;;)
     {
       char c;
+
+      /* Show the prompt and echoed input, which stdout would
+         otherwise hold until the end of the line. */
+      fflush (stdout);
       read (STDIN_FILENO, &c, 1);
 
       switch (c)
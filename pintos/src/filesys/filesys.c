@@ -19,6 +19,8 @@ void filesys_init(bool format) {
     if (fs_device == NULL) PANIC("No file system device found, can't initialize file system.");
 
     inode_init();
+    file_init();
+    dir_init();
     free_map_init();
 
     if (format) do_format();
@@ -17,7 +17,7 @@ void free_map_init(void) {
     if (free_map == NULL) PANIC("bitmap creation failed--file system device is too large");
     bitmap_mark(free_map, FREE_MAP_SECTOR);
     bitmap_mark(free_map, ROOT_DIR_SECTOR);
-    lock_init(&map_lock);
+    lock_init_named(&map_lock, "free map");
 }
 
 bool lock_acquire_helper(struct lock *lock) {
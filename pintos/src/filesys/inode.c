@@ -8,14 +8,22 @@
 #include "filesys/free-map.h"
 #include "filesys/inode_utils.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 
 /* List of open inodes, so that opening a single inode twice
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache of `struct inode's. */
+static struct kmem_cache *inode_cache;
+
 /* Initializes the inode module. */
-void inode_init(void) { list_init(&open_inodes); }
+void inode_init(void) {
+    list_init(&open_inodes);
+    inode_cache = kmem_cache_create("inode", sizeof(struct inode), NULL);
+    if (inode_cache == NULL) PANIC("inode cache creation failed");
+}
 
 /* Initializes an inode with LENGTH bytes of data and
    writes the new inode to sector SECTOR on the file system
@@ -67,7 +75,7 @@ struct inode *inode_open(block_sector_t sector) {
     }
 
     /* Allocate memory. */
-    inode = malloc(sizeof *inode);
+    inode = kmem_cache_alloc(inode_cache);
     if (inode == NULL) return NULL;
 
     /* Initialize. */
@@ -106,7 +114,7 @@ void inode_close(struct inode *inode) {
             release_inode(inode);
         }
 
-        free(inode);
+        kmem_cache_free(inode_cache, inode);
     }
 }
 
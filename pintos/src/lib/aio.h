@@ -0,0 +1,62 @@
+#ifndef __LIB_AIO_H
+#define __LIB_AIO_H
+
+/* Asynchronous I/O rings, shared between a user process and the
+   kernel.
+
+   aio_setup() maps one aio_ring into the calling process.  The
+   process queues requests by filling in sqes[sq_tail % AIO_ENTRIES]
+   and then incrementing sq_tail, and hands them to the kernel
+   with aio_enter().  Kernel threads carry the requests out in
+   the background and post a completion for each one, in
+   whatever order they finish, at cqes[cq_tail % AIO_ENTRIES].
+   The process consumes completions by incrementing cq_head.
+
+   Each ring index is written only by one side: sq_tail and
+   cq_head by the process, sq_head and cq_tail by the kernel.
+   The indexes run freely and wrap around at 2**32, so the number
+   of entries in a ring is always its tail minus its head. */
+
+#include <stdint.h>
+
+/* Number of entries in each ring.  At most this many requests
+   can be in flight or have unconsumed completions at once. */
+#define AIO_ENTRIES 64
+
+/* Request types. */
+enum aio_op
+  {
+    AIO_READ,                   /* Read from a file at an offset. */
+    AIO_WRITE                   /* Write to a file at an offset. */
+  };
+
+/* Submission queue entry: one request. */
+struct aio_sqe
+  {
+    uint32_t op;                /* An enum aio_op. */
+    int fd;                     /* File descriptor of an open file. */
+    void *buffer;               /* Data to read into or write from. */
+    uint32_t size;              /* Number of bytes. */
+    uint32_t offset;            /* File offset. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* Completion queue entry: the outcome of one request. */
+struct aio_cqe
+  {
+    uint32_t user_data;         /* From the request. */
+    int result;                 /* Bytes transferred, or -1. */
+  };
+
+/* Submission and completion rings. */
+struct aio_ring
+  {
+    volatile uint32_t sq_head;  /* Next request the kernel takes. */
+    volatile uint32_t sq_tail;  /* Where the next request goes. */
+    volatile uint32_t cq_head;  /* Next completion to consume. */
+    volatile uint32_t cq_tail;  /* Where the next completion goes. */
+    struct aio_sqe sqes[AIO_ENTRIES];
+    struct aio_cqe cqes[AIO_ENTRIES];
+  };
+
+#endif /* lib/aio.h */
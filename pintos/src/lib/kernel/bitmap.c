@@ -69,6 +69,60 @@ last_mask (const struct bitmap *b)
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns a mask of the bits in element ELEM_IDX that fall in
+   the range of bitmap bits from START to END, exclusive.  The
+   element must overlap the range. */
+static inline elem_type
+range_mask (size_t elem_idx, size_t start, size_t end)
+{
+  size_t base = elem_idx * ELEM_BITS;
+  size_t lo = start > base ? start - base : 0;
+  size_t hi = end - base < ELEM_BITS ? end - base : ELEM_BITS;
+  elem_type high_mask = hi < ELEM_BITS ? ((elem_type) 1 << hi) - 1 : (elem_type) -1;
+
+  return high_mask & ~(((elem_type) 1 << lo) - 1);
+}
+
+/* Returns the number of 1-bits in X, which must be 32 bits wide.
+   (GCC's __builtin_popcount would need libgcc.) */
+static inline size_t
+popcount (elem_type x)
+{
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  x = (x + (x >> 4)) & 0x0f0f0f0f;
+  return (x * 0x01010101) >> 24;
+}
+
+/* Returns the index of the first bit in B at or after START
+   that is set to VALUE, or the size of B if there is none.
+   Whole elements that contain no such bit are skipped at once. */
+static size_t
+next_bit (const struct bitmap *b, size_t start, bool value)
+{
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t idx, last_idx, bit_idx;
+  elem_type word;
+
+  if (start >= b->bit_cnt)
+    return b->bit_cnt;
+
+  idx = elem_idx (start);
+  last_idx = elem_idx (b->bit_cnt - 1);
+  word = (b->bits[idx] ^ flip) & ~(bit_mask (start) - 1);
+  while (word == 0)
+    {
+      if (++idx > last_idx)
+        return b->bit_cnt;
+      word = b->bits[idx] ^ flip;
+    }
+
+  /* Unused bits past the end of the last element read as 1
+     when searching for 0, so clamp to the bitmap's size. */
+  bit_idx = idx * ELEM_BITS + __builtin_ctzl (word);
+  return bit_idx < b->bit_cnt ? bit_idx : b->bit_cnt;
+}
+
 /* Creation and destruction. */
 
 /* Creates and returns a pointer to a newly allocated bitmap with room for
@@ -213,18 +267,32 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, as with bitmap_set(). */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 {
-  size_t i;
+  size_t end = start + cnt;
+  size_t idx;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  if (cnt == 0)
+    return;
+
+  for (idx = elem_idx (start); idx <= elem_idx (end - 1); idx++)
+    {
+      elem_type mask = range_mask (idx, start, end);
+
+      if (mask == (elem_type) -1)
+        b->bits[idx] = value ? (elem_type) -1 : 0;
+      else if (value)
+        asm ("orl %1, %0" : "+m" (b->bits[idx]) : "r" (mask) : "cc");
+      else
+        asm ("andl %1, %0" : "+m" (b->bits[idx]) : "r" (~mask) : "cc");
+    }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -232,17 +300,20 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 {
-  size_t i, value_cnt;
+  size_t end = start + cnt;
+  size_t idx, true_cnt;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
-  return value_cnt;
+  if (cnt == 0)
+    return 0;
+
+  true_cnt = 0;
+  for (idx = elem_idx (start); idx <= elem_idx (end - 1); idx++)
+    true_cnt += popcount (b->bits[idx] & range_mask (idx, start, end));
+  return value ? true_cnt : cnt - true_cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -250,14 +321,19 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value)
 {
-  size_t i;
+  size_t end = start + cnt;
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t idx;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
+  if (cnt == 0)
+    return false;
+
+  for (idx = elem_idx (start); idx <= elem_idx (end - 1); idx++)
+    if (((b->bits[idx] ^ flip) & range_mask (idx, start, end)) != 0)
       return true;
   return false;
 }
@@ -291,20 +367,35 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt)
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+
+   Works run by run: finds the next bit set to VALUE, then the
+   end of the run it starts, and moves past the whole run if it
+   is too short. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
 {
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
+  if (cnt == 0)
+    return start;
   if (cnt <= b->bit_cnt)
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i;
+      size_t i = start;
+      while (i <= last)
+        {
+          size_t run_end;
+
+          i = next_bit (b, i, value);
+          if (i > last)
+            break;
+          run_end = next_bit (b, i + 1, !value);
+          if (run_end - i >= cnt)
+            return i;
+          i = run_end;
+        }
     }
   return BITMAP_ERROR;
 }
@@ -63,7 +63,7 @@ static int64_t write_cnt;
 void
 console_init (void)
 {
-  lock_init (&console_lock);
+  lock_init_named (&console_lock, "console");
   use_console_lock = true;
 }
 
@@ -148,13 +148,15 @@ puts (const char *s)
   return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console, handing
+   the whole run to each output device at once. */
 void
 putbuf (const char *buffer, size_t n)
 {
   acquire_console ();
-  while (n-- > 0)
-    putchar_have_lock (*buffer++);
+  write_cnt += n;
+  serial_putbuf ((const uint8_t *) buffer, n);
+  vga_putbuf (buffer, n);
   release_console ();
 }
 
@@ -1,5 +1,15 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* Blocks shorter than this are copied or set a byte at a time,
+   since aligning them and setting up a string instruction would
+   cost more than it saves. */
+#define WORD_THRESHOLD 16
+
+/* A 32-bit word that may alias any other type, for comparing
+   blocks of memory a word at a time. */
+typedef uint32_t __attribute__ ((may_alias)) alias_word;
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,6 +22,22 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
+  /* Copy bytes until DST is word-aligned, then whole words with
+     `rep movsl', then the remaining bytes. */
+  if (size >= WORD_THRESHOLD)
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words;
+
+      size -= head;
+      while (head-- > 0)
+        *dst++ = *src++;
+
+      words = size / 4;
+      size %= 4;
+      asm volatile ("rep movsl"
+                    : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+    }
   while (size-- > 0)
     *dst++ = *src++;
 
@@ -31,18 +57,42 @@ memmove (void *dst_, const void *src_, size_t size)
 
   if (dst < src)
     {
-      while (size-- > 0)
-        *dst++ = *src++;
+      /* Copying upward never overwrites source bytes that have
+         not been read yet. */
+      memcpy (dst, src, size);
     }
   else
     {
       dst += size;
       src += size;
+
+      /* Copy bytes downward until the end of DST is word-aligned,
+         then whole words with `std; rep movsl', then the remaining
+         bytes.  Interrupt handlers clear the direction flag on
+         entry and restore it on return. */
+      if (size >= WORD_THRESHOLD)
+        {
+          size_t tail = (uintptr_t) dst & 3;
+          size_t words;
+
+          size -= tail;
+          while (tail-- > 0)
+            *--dst = *--src;
+
+          words = size / 4;
+          size %= 4;
+          dst -= 4;
+          src -= 4;
+          asm volatile ("std; rep movsl; cld"
+                        : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+          dst += 4;
+          src += 4;
+        }
       while (size-- > 0)
         *--dst = *--src;
     }
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +108,10 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words, then find the differing byte. */
+  for (; size >= 4; a += 4, b += 4, size -= 4)
+    if (*(const alias_word *) a != *(const alias_word *) b)
+      break;
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -282,6 +336,23 @@ memset (void *dst_, int value, size_t size)
 
   ASSERT (dst != NULL || size == 0);
 
+  /* Set bytes until DST is word-aligned, then whole words with
+     `rep stosl', then the remaining bytes. */
+  if (size >= WORD_THRESHOLD)
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      uint32_t fill = (unsigned char) value * 0x01010101u;
+      size_t words;
+
+      size -= head;
+      while (head-- > 0)
+        *dst++ = value;
+
+      words = size / 4;
+      size %= 4;
+      asm volatile ("rep stosl"
+                    : "+D" (dst), "+c" (words) : "a" (fill) : "memory");
+    }
   while (size-- > 0)
     *dst++ = value;
 
@@ -29,7 +29,33 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Heap. */
+    SYS_SBRK,                   /* Grow or shrink the heap. */
+
+    /* Pipes. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP2,                   /* Redirect stdin or stdout. */
+
+    /* User threads. */
+    SYS_PT_CREATE,              /* Start a thread in this process. */
+    SYS_PT_EXIT,                /* Terminate this thread. */
+    SYS_PT_JOIN,                /* Wait for a thread to terminate. */
+    SYS_GET_TID,                /* Return this thread's identifier. */
+    SYS_FUTEX_WAIT,             /* Sleep if an int holds a value. */
+    SYS_FUTEX_WAKE,             /* Wake threads sleeping on an int. */
+
+    /* Asynchronous I/O. */
+    SYS_AIO_SETUP,              /* Map submission/completion rings. */
+    SYS_AIO_ENTER,              /* Submit requests, await completions. */
+
+    /* Time. */
+    SYS_CLOCK_NS,               /* Read the high-resolution clock. */
+
+    /* Diagnostics. */
+    SYS_SCHED_DUMP,             /* Print scheduler accounting and events. */
+    SYS_BLOCK_STATS             /* Count file system sectors transferred. */
   };
 
 #endif /* lib/syscall-nr.h */
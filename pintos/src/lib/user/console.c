@@ -8,7 +8,7 @@
 int
 vprintf (const char *format, va_list args)
 {
-  return vhprintf (STDOUT_FILENO, format, args);
+  return vfprintf (stdout, format, args);
 }
 
 /* Like printf(), but writes output to the given HANDLE. */
@@ -30,7 +30,7 @@ hprintf (int handle, const char *format, ...)
 int
 puts (const char *s)
 {
-  write (STDOUT_FILENO, s, strlen (s));
+  fputs (s, stdout);
   putchar ('\n');
 
   return 0;
@@ -40,9 +40,7 @@ puts (const char *s)
 int
 putchar (int c)
 {
-  char c2 = c;
-  write (STDOUT_FILENO, &c2, 1);
-  return c;
+  return fputc (c, stdout);
 }
 
 /* Auxiliary data for vhprintf_helper(). */
@@ -59,11 +57,16 @@ static void flush (struct vhprintf_aux *);
 
 /* Formats the printf() format specification FORMAT with
    arguments given in ARGS and writes the output to the given
-   HANDLE. */
+   HANDLE.  Output to STDOUT_FILENO goes through stdout's
+   buffer. */
 int
 vhprintf (int handle, const char *format, va_list args)
 {
   struct vhprintf_aux aux;
+
+  if (handle == STDOUT_FILENO)
+    return vfprintf (stdout, format, args);
+
   aux.p = aux.buf;
   aux.char_cnt = 0;
   aux.handle = handle;
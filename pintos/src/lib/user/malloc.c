@@ -0,0 +1,433 @@
+#include <stdlib.h>
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A user-space memory allocator on top of sbrk().
+
+   Every block, allocated or free, begins with an 8-byte header
+   that holds the block's size (header included) and flags, and
+   the size of the block just before it in memory.  Blocks are
+   multiples of 8 bytes, so the payload that follows the header
+   is always 8-byte aligned.
+
+   Requests of up to MAX_SMALL bytes are rounded up to a power
+   of 2 ("size class").  Each class has its own free list, so
+   small blocks are allocated and freed in constant time with no
+   searching.  Small blocks are carved out of larger "runs" and
+   never coalesced; a freed small block waits on its class's
+   list for the next request of the same class.
+
+   Larger requests, and the runs themselves, come from a
+   first-fit list of free blocks that are split on allocation
+   and coalesced with free neighbors on release, using the
+   sizes in the headers as boundary tags.  A permanently
+   allocated, zero-size block at the end of the heap stops
+   coalescing from running past the break.  When no free block
+   is big enough, the heap grows with sbrk(), and a large free
+   block that ends up at the top of the heap is given back. */
+
+/* Block header. */
+struct header
+  {
+    size_t size;                /* Block size plus flag bits. */
+    size_t prev_size;           /* Size of previous block, or 0. */
+  };
+
+/* Flag bits in a block's size. */
+#define IN_USE 1                /* Allocated. */
+#define SMALL 2                 /* Belongs to a size class. */
+#define FLAGS (IN_USE | SMALL)
+
+/* A free block's payload links it into a free list. */
+struct free_block
+  {
+    struct header header;
+    struct free_block *prev;    /* Previous free block. */
+    struct free_block *next;    /* Next free block. */
+  };
+
+/* Size classes hold payloads of 8, 16, 32, ..., MAX_SMALL bytes. */
+#define MIN_SMALL 8
+#define MAX_SMALL 1024
+#define CLASS_CNT 8
+
+/* Bytes of small blocks carved out of one run, at least. */
+#define RUN_SIZE 4096
+
+/* Smallest block worth splitting off a large block. */
+#define MIN_BLOCK sizeof (struct free_block)
+
+/* Minimum amount to grow the heap by, and size of a free block
+   at the top of the heap that is returned to the kernel. */
+#define GROW_SIZE (16 * 1024)
+#define TRIM_SIZE (64 * 1024)
+
+static struct header *small_free[CLASS_CNT];  /* Free small blocks. */
+static struct free_block *large_free;         /* Free large blocks. */
+static struct header *heap_base;              /* First block. */
+static struct header *heap_end;               /* End sentinel. */
+
+static void *large_alloc (size_t size);
+static struct free_block *large_free_block (struct header *);
+static void trim_heap (struct free_block *);
+static bool grow_heap (size_t size);
+
+/* Returns the size of block H, without flags. */
+static inline size_t
+block_size (const struct header *h)
+{
+  return h->size & ~(size_t) FLAGS;
+}
+
+/* Returns the block that follows H in memory. */
+static inline struct header *
+next_block (struct header *h)
+{
+  return (struct header *) ((uint8_t *) h + block_size (h));
+}
+
+/* Returns the block that precedes H in memory, or a null pointer
+   if H is the first block. */
+static inline struct header *
+prev_block (struct header *h)
+{
+  return h->prev_size != 0
+          ? (struct header *) ((uint8_t *) h - h->prev_size) : NULL;
+}
+
+/* Sets the size of block H to SIZE with the given FLAGS, and
+   records SIZE in the following block's header. */
+static inline void
+set_size (struct header *h, size_t size, size_t flags)
+{
+  h->size = size | flags;
+  next_block (h)->prev_size = size;
+}
+
+/* Removes F from the list of free large blocks. */
+static void
+unlink_free (struct free_block *f)
+{
+  if (f->prev != NULL)
+    f->prev->next = f->next;
+  else
+    large_free = f->next;
+  if (f->next != NULL)
+    f->next->prev = f->prev;
+}
+
+/* Returns the size class for a SIZE-byte request, which must be
+   at most MAX_SMALL. */
+static inline int
+size_class (size_t size)
+{
+  return size <= MIN_SMALL ? 0 : 32 - __builtin_clz (size - 1) - 3;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size)
+{
+  struct header *h;
+
+  if (size == 0)
+    return NULL;
+
+  if (size <= MAX_SMALL)
+    {
+      int class = size_class (size);
+
+      if (small_free[class] == NULL)
+        {
+          /* Carve a new run into blocks of this class.  The run
+             stays allocated for good. */
+          size_t block = sizeof (struct header) + (MIN_SMALL << class);
+          size_t cnt = RUN_SIZE / block < 8 ? 8 : RUN_SIZE / block;
+          uint8_t *run = large_alloc (cnt * block);
+          size_t i;
+
+          if (run == NULL)
+            return NULL;
+          for (i = 0; i < cnt; i++)
+            {
+              h = (struct header *) (run + i * block);
+              h->size = block | SMALL;
+              h->prev_size = (size_t) small_free[class];
+              small_free[class] = h;
+            }
+        }
+
+      /* A free small block's prev_size links it to the next free
+         block of its class. */
+      h = small_free[class];
+      small_free[class] = (struct header *) h->prev_size;
+      h->size |= IN_USE;
+      return h + 1;
+    }
+
+  return large_alloc (size);
+}
+
+/* Allocates and return A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b)
+{
+  void *p;
+  size_t size;
+
+  /* Calculate block size and make sure it fits in size_t. */
+  size = a * b;
+  if (b != 0 && size / b != a)
+    return NULL;
+
+  p = malloc (size);
+  if (p != NULL)
+    memset (p, 0, size);
+
+  return p;
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+void *
+realloc (void *old_block, size_t new_size)
+{
+  struct header *h;
+  size_t old_size;
+  void *new_block;
+
+  if (new_size == 0)
+    {
+      free (old_block);
+      return NULL;
+    }
+  if (old_block == NULL)
+    return malloc (new_size);
+
+  h = (struct header *) old_block - 1;
+  ASSERT (h->size & IN_USE);
+  old_size = block_size (h) - sizeof *h;
+
+  if (h->size & SMALL)
+    {
+      /* A small block can't grow, but it can stay put as long as
+         the new size falls in the same class or it is shrinking
+         by less than half. */
+      if (new_size <= old_size
+          && (new_size > old_size / 2 || old_size == MIN_SMALL))
+        return old_block;
+    }
+  else if (new_size > MAX_SMALL)
+    {
+      size_t need = ROUND_UP (new_size, 8) + sizeof *h;
+      struct header *next = next_block (h);
+
+      /* Absorb a free block that follows, if that is enough. */
+      if (!(next->size & IN_USE) && block_size (h) < need
+          && block_size (h) + block_size (next) >= need)
+        {
+          unlink_free ((struct free_block *) next);
+          set_size (h, block_size (h) + block_size (next), IN_USE);
+        }
+
+      if (block_size (h) >= need)
+        {
+          /* Give back the tail, if it is big enough to be worth
+             keeping track of. */
+          if (block_size (h) - need >= MIN_BLOCK + MAX_SMALL)
+            {
+              struct header *tail = (struct header *) ((uint8_t *) h + need);
+              set_size (tail, block_size (h) - need, IN_USE);
+              set_size (h, need, IN_USE);
+              large_free_block (tail);
+            }
+          return old_block;
+        }
+    }
+
+  new_block = malloc (new_size);
+  if (new_block != NULL)
+    {
+      memcpy (new_block, old_block,
+              old_size < new_size ? old_size : new_size);
+      free (old_block);
+    }
+  return new_block;
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p)
+{
+  struct header *h;
+
+  if (p == NULL)
+    return;
+
+  h = (struct header *) p - 1;
+  ASSERT (h->size & IN_USE);
+
+  if (h->size & SMALL)
+    {
+#ifndef NDEBUG
+      /* Clear the block to help detect use-after-free bugs. */
+      memset (p, 0xcc, block_size (h) - sizeof *h);
+#endif
+      h->size &= ~(size_t) IN_USE;
+      h->prev_size = (size_t) small_free[size_class (block_size (h)
+                                                      - sizeof *h)];
+      small_free[size_class (block_size (h) - sizeof *h)] = h;
+    }
+  else
+    trim_heap (large_free_block (h));
+}
+
+/* Allocates a large block with at least SIZE bytes of payload,
+   growing the heap if necessary.  Returns the payload, or a
+   null pointer if memory is not available. */
+static void *
+large_alloc (size_t size)
+{
+  size_t need;
+  struct free_block *f;
+
+  if (size > SIZE_MAX / 2)
+    return NULL;
+  need = ROUND_UP (size, 8) + sizeof (struct header);
+  if (need < MIN_BLOCK)
+    need = MIN_BLOCK;
+
+  for (;;)
+    {
+      for (f = large_free; f != NULL; f = f->next)
+        if (block_size (&f->header) >= need)
+          break;
+      if (f != NULL)
+        break;
+      if (!grow_heap (need))
+        return NULL;
+    }
+
+  unlink_free (f);
+
+  /* Split off the tail, if it can stand as a block of its own. */
+  if (block_size (&f->header) - need >= MIN_BLOCK)
+    {
+      struct header *tail = (struct header *) ((uint8_t *) f + need);
+      set_size (tail, block_size (&f->header) - need, IN_USE);
+      set_size (&f->header, need, IN_USE);
+      large_free_block (tail);
+    }
+  else
+    f->header.size |= IN_USE;
+
+  return &f->header + 1;
+}
+
+/* Frees large block H, coalescing it with free neighbors, and
+   returns the resulting free block. */
+static struct free_block *
+large_free_block (struct header *h)
+{
+  struct header *next = next_block (h);
+  struct header *prev = prev_block (h);
+  struct free_block *f;
+  size_t size = block_size (h);
+
+  if (!(next->size & IN_USE))
+    {
+      /* Absorb the following block. */
+      unlink_free ((struct free_block *) next);
+      size += block_size (next);
+    }
+
+  if (prev != NULL && !(prev->size & IN_USE))
+    {
+      /* Merge into the preceding block, which is already on the
+         free list. */
+      size += block_size (prev);
+      f = (struct free_block *) prev;
+    }
+  else
+    {
+      f = (struct free_block *) h;
+      f->prev = NULL;
+      f->next = large_free;
+      if (large_free != NULL)
+        large_free->prev = f;
+      large_free = f;
+    }
+  set_size (&f->header, size, 0);
+  return f;
+}
+
+/* If free block F is at the top of the heap and is large, gives
+   most of it back to the kernel, keeping GROW_SIZE bytes to
+   avoid growing again right away. */
+static void
+trim_heap (struct free_block *f)
+{
+  size_t size = block_size (&f->header);
+
+  if (next_block (&f->header) == heap_end && size >= TRIM_SIZE)
+    {
+      size_t trim = ROUND_DOWN (size - GROW_SIZE, 4096);
+      struct header *end = (struct header *) ((uint8_t *) heap_end - trim);
+
+      if (sbrk (-(intptr_t) trim) != (void *) -1)
+        {
+          set_size (&f->header, size - trim, 0);
+          end->size = IN_USE;
+          heap_end = end;
+        }
+    }
+}
+
+/* Grows the heap so that a free block of at least SIZE bytes
+   exists at its top.  Returns true if successful, false if the
+   kernel refuses. */
+static bool
+grow_heap (size_t size)
+{
+  size_t increment = size < GROW_SIZE ? GROW_SIZE : ROUND_UP (size, 4096);
+  struct header *h;
+  uint8_t *old_break;
+
+  if (heap_base == NULL)
+    {
+      /* Align the first block and create the end sentinel. */
+      old_break = sbrk (0);
+      if (old_break == (void *) -1
+          || sbrk (ROUND_UP ((uintptr_t) old_break, 8) - (uintptr_t) old_break
+                   + sizeof *h) == (void *) -1)
+        return false;
+      heap_base = heap_end = (struct header *) ROUND_UP ((uintptr_t) old_break,
+                                                          8);
+      heap_end->size = IN_USE;
+      heap_end->prev_size = 0;
+    }
+
+  old_break = sbrk (increment);
+  if (old_break == (void *) -1)
+    return false;
+  ASSERT (old_break == (uint8_t *) (heap_end + 1));
+
+  /* The old sentinel becomes the header of a new block, which
+     is freed to merge it with any free block below it. */
+  h = heap_end;
+  heap_end = (struct header *) ((uint8_t *) h + increment);
+  heap_end->size = IN_USE;
+  set_size (h, increment, IN_USE);
+  large_free_block (h);
+  return true;
+}
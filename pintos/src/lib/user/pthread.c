@@ -0,0 +1,172 @@
+#include <pthread.h>
+#include <syscall.h>
+
+static void start_thread (pthread_fun, void *arg) NO_RETURN;
+
+/* Starts a new thread running FUN(ARG) in this process and
+   returns its identifier, or TID_ERROR if it could not be
+   created.  The thread exits when FUN returns. */
+tid_t
+pthread_create (pthread_fun fun, void *arg)
+{
+  return sys_pthread_create (start_thread, fun, arg);
+}
+
+/* Waits for thread TID, which must belong to this process and
+   not be its main thread, to exit.  Returns false if there is
+   no such thread or it has already been joined. */
+bool
+pthread_join (tid_t tid)
+{
+  return sys_pthread_join (tid) == tid;
+}
+
+/* Terminates the running thread. */
+void
+pthread_exit (void)
+{
+  sys_pthread_exit ();
+}
+
+/* Where every new thread begins, in user mode: runs the
+   thread's function and then exits the thread. */
+static void
+start_thread (pthread_fun fun, void *arg)
+{
+  fun (arg);
+  pthread_exit ();
+}
+
+/* Atomically sets *P to NEW if it equals OLD.  Returns the
+   previous value of *P. */
+static inline int
+atomic_cmpxchg (int *p, int old, int new)
+{
+  asm volatile ("lock cmpxchgl %2, %1"
+                : "+a" (old), "+m" (*p) : "r" (new) : "memory");
+  return old;
+}
+
+/* Atomically sets *P to NEW and returns its previous value. */
+static inline int
+atomic_xchg (int *p, int new)
+{
+  asm volatile ("xchgl %0, %1" : "+r" (new), "+m" (*p) : : "memory");
+  return new;
+}
+
+/* Atomically adds N to *P and returns its previous value. */
+static inline int
+atomic_add (int *p, int n)
+{
+  asm volatile ("lock xaddl %0, %1" : "+r" (n), "+m" (*p) : : "memory");
+  return n;
+}
+
+/* Mutexes, following "Futexes Are Tricky" by Ulrich Drepper.
+   A mutex's state is 0 when it is unlocked, 1 when it is locked
+   with no other thread waiting, and 2 when other threads may be
+   waiting.  Only a thread that finds it locked goes to sleep in
+   the kernel, and only an unlock from state 2 wakes one up. */
+
+/* Initializes M to unlocked. */
+void
+pthread_mutex_init (pthread_mutex_t *m)
+{
+  m->state = 0;
+}
+
+/* Locks M, sleeping until it is available if necessary. */
+void
+pthread_mutex_lock (pthread_mutex_t *m)
+{
+  int c = atomic_cmpxchg (&m->state, 0, 1);
+
+  if (c != 0)
+    {
+      /* Mark the mutex contended, since we are about to wait,
+         and sleep until an unlock lets us take it.  Taking it
+         leaves it marked contended, because we cannot tell
+         whether anyone else is still waiting. */
+      if (c != 2)
+        c = atomic_xchg (&m->state, 2);
+      while (c != 0)
+        {
+          futex_wait (&m->state, 2);
+          c = atomic_xchg (&m->state, 2);
+        }
+    }
+}
+
+/* Locks M if it is unlocked.  Returns true if successful, false
+   if M is already locked. */
+bool
+pthread_mutex_trylock (pthread_mutex_t *m)
+{
+  return atomic_cmpxchg (&m->state, 0, 1) == 0;
+}
+
+/* Unlocks M, which the running thread must have locked, and
+   wakes up a thread waiting for it, if any might be. */
+void
+pthread_mutex_unlock (pthread_mutex_t *m)
+{
+  if (atomic_add (&m->state, -1) != 1)
+    {
+      m->state = 0;
+      futex_wake (&m->state, 1);
+    }
+}
+
+/* Condition variables.  A waiter notes the sequence number
+   before releasing the mutex and sleeps only if no signal has
+   changed it since, so a signal sent in between is not lost.
+   The count of waiters lets a signal with nobody to wake skip
+   the kernel. */
+
+/* Initializes C. */
+void
+pthread_cond_init (pthread_cond_t *c)
+{
+  c->seq = 0;
+  c->waiters = 0;
+}
+
+/* Atomically releases M, which the running thread must hold,
+   and waits for C to be signaled, then locks M again.  As with
+   any condition variable, the caller must recheck its condition
+   afterward. */
+void
+pthread_cond_wait (pthread_cond_t *c, pthread_mutex_t *m)
+{
+  int seq;
+
+  atomic_add (&c->waiters, 1);
+  seq = c->seq;
+  pthread_mutex_unlock (m);
+  futex_wait (&c->seq, seq);
+  atomic_add (&c->waiters, -1);
+
+  /* Other threads may have been woken with us, so lock M as
+     contended to make sure its unlock wakes them. */
+  while (atomic_xchg (&m->state, 2) != 0)
+    futex_wait (&m->state, 2);
+}
+
+/* Wakes up one thread waiting on C, if any. */
+void
+pthread_cond_signal (pthread_cond_t *c)
+{
+  atomic_add (&c->seq, 1);
+  if (c->waiters > 0)
+    futex_wake (&c->seq, 1);
+}
+
+/* Wakes up every thread waiting on C. */
+void
+pthread_cond_broadcast (pthread_cond_t *c)
+{
+  atomic_add (&c->seq, 1);
+  if (c->waiters > 0)
+    futex_wake (&c->seq, c->waiters);
+}
@@ -0,0 +1,55 @@
+#ifndef __LIB_USER_PTHREAD_H
+#define __LIB_USER_PTHREAD_H
+
+#include <stdbool.h>
+#include <syscall.h>
+
+/* Threads within a process.
+
+   Every thread in a process shares its memory and open files,
+   and has a one-page stack of its own.  A process may have up to
+   31 threads besides its main thread.  The process ends when its
+   main thread exits, once all of its other threads have exited
+   too; exit() in any thread, or a thread being killed, makes the
+   others exit as well, even if they are blocked in a system call
+   or running without making any.
+
+   malloc() and the stdio streams keep no locks of their own, so
+   threads must not use them at the same time. */
+
+tid_t pthread_create (pthread_fun, void *arg);
+bool pthread_join (tid_t);
+void pthread_exit (void) NO_RETURN;
+
+/* Mutex.  Locking and unlocking a mutex that no other thread
+   wants never enters the kernel. */
+typedef struct
+  {
+    int state;                  /* 0=unlocked, 1=locked, 2=contended. */
+  }
+pthread_mutex_t;
+
+#define PTHREAD_MUTEX_INITIALIZER { 0 }
+
+void pthread_mutex_init (pthread_mutex_t *);
+void pthread_mutex_lock (pthread_mutex_t *);
+bool pthread_mutex_trylock (pthread_mutex_t *);
+void pthread_mutex_unlock (pthread_mutex_t *);
+
+/* Condition variable.  Signaling one that no thread is waiting
+   on never enters the kernel. */
+typedef struct
+  {
+    int seq;                    /* Bumped by every signal. */
+    int waiters;                /* Threads in pthread_cond_wait(). */
+  }
+pthread_cond_t;
+
+#define PTHREAD_COND_INITIALIZER { 0, 0 }
+
+void pthread_cond_init (pthread_cond_t *);
+void pthread_cond_wait (pthread_cond_t *, pthread_mutex_t *);
+void pthread_cond_signal (pthread_cond_t *);
+void pthread_cond_broadcast (pthread_cond_t *);
+
+#endif /* lib/user/pthread.h */
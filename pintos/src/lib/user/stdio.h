@@ -4,4 +4,39 @@
 int hprintf (int, const char *, ...) PRINTF_FORMAT (2, 3);
 int vhprintf (int, const char *, va_list) PRINTF_FORMAT (2, 0);
 
+/* Buffered streams. */
+typedef struct stream FILE;
+extern FILE *stdin;
+extern FILE *stdout;
+
+/* Buffering modes for setvbuf(). */
+#define _IOFBF 0                /* Full buffering. */
+#define _IOLBF 1                /* Line buffering. */
+#define _IONBF 2                /* No buffering. */
+
+/* Default stream buffer size. */
+#define BUFSIZ 512
+
+/* Returned by character input and output functions on failure. */
+#define EOF (-1)
+
+FILE *fdopen (int fd, const char *mode);
+int fclose (FILE *);
+int fflush (FILE *);
+int setvbuf (FILE *, char *, int mode, size_t);
+int fileno (FILE *);
+int feof (FILE *);
+int ferror (FILE *);
+
+size_t fwrite (const void *, size_t, size_t, FILE *);
+int fputc (int, FILE *);
+int fputs (const char *, FILE *);
+int fprintf (FILE *, const char *, ...) PRINTF_FORMAT (2, 3);
+int vfprintf (FILE *, const char *, va_list) PRINTF_FORMAT (2, 0);
+
+size_t fread (void *, size_t, size_t, FILE *);
+int fgetc (FILE *);
+char *fgets (char *, int, FILE *);
+int getchar (void);
+
 #endif /* lib/user/stdio.h */
@@ -0,0 +1,536 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Buffered streams.
+
+   A stream gathers output in a buffer and hands it to write()
+   all at once, and fills a buffer with one read() and hands
+   input out of it piece by piece, so that printing or reading a
+   character at a time does not cost a system call each time.
+
+   In full buffering mode, output is written only when the buffer
+   fills up or the stream is flushed.  In line buffering mode, it
+   is also written at the end of each line, which is the default
+   for stdout so that interactive output appears promptly and
+   interleaves sensibly with other processes' output.  Unbuffered
+   streams pass every operation straight through.
+
+   All streams are flushed when the process calls exit(). */
+
+/* A stream. */
+struct stream
+  {
+    int fd;                     /* File descriptor. */
+    int mode;                   /* _IOFBF, _IOLBF, or _IONBF. */
+    bool can_read;              /* Opened for reading? */
+    bool can_write;             /* Opened for writing? */
+    bool writing;               /* Buffer holds output, not input? */
+    bool eof;                   /* End of file seen? */
+    bool error;                 /* Error seen? */
+    bool own_buf;               /* Was buf malloc()'d by us? */
+    char *buf;                  /* Buffer. */
+    size_t size;                /* Size of buffer. */
+    char *pos;                  /* Next byte to read or write. */
+    char *end;                  /* End of buffered input. */
+    struct stream *next;        /* Next in all_streams. */
+  };
+
+static char stdin_buf[BUFSIZ];
+static char stdout_buf[BUFSIZ];
+
+static struct stream stdout_stream =
+  {
+    STDOUT_FILENO, _IOLBF, false, true, true, false, false, false,
+    stdout_buf, sizeof stdout_buf, stdout_buf, stdout_buf, NULL
+  };
+static struct stream stdin_stream =
+  {
+    STDIN_FILENO, _IOLBF, true, false, false, false, false, false,
+    stdin_buf, sizeof stdin_buf, stdin_buf, stdin_buf, &stdout_stream
+  };
+
+FILE *stdin = &stdin_stream;
+FILE *stdout = &stdout_stream;
+
+/* Every open stream, for fflush (NULL). */
+static struct stream *all_streams = &stdin_stream;
+
+static bool flush_output (FILE *);
+static bool start_writing (FILE *);
+static bool start_reading (FILE *);
+static bool fill (FILE *);
+
+/* Opens a stream on file descriptor FD, which is then owned by
+   the stream.  MODE is "r" for reading, "w" or "a" for writing,
+   or either of those followed by "+" for both.  Returns the new
+   stream, or a null pointer if MODE is invalid or memory is not
+   available. */
+FILE *
+fdopen (int fd, const char *mode)
+{
+  FILE *s;
+
+  if (mode[0] != 'r' && mode[0] != 'w' && mode[0] != 'a')
+    return NULL;
+
+  s = malloc (sizeof *s);
+  if (s == NULL)
+    return NULL;
+  s->buf = malloc (BUFSIZ);
+  if (s->buf == NULL)
+    {
+      free (s);
+      return NULL;
+    }
+
+  s->fd = fd;
+  s->mode = _IOFBF;
+  s->can_read = mode[0] == 'r' || strchr (mode, '+') != NULL;
+  s->can_write = mode[0] != 'r' || strchr (mode, '+') != NULL;
+  s->writing = !s->can_read;
+  s->eof = s->error = false;
+  s->own_buf = true;
+  s->size = BUFSIZ;
+  s->pos = s->end = s->buf;
+
+  s->next = all_streams;
+  all_streams = s;
+  return s;
+}
+
+/* Flushes stream S, closes its file descriptor, and frees it.
+   Returns 0 if successful, EOF if flushing failed. */
+int
+fclose (FILE *s)
+{
+  struct stream **sp;
+  int retval = fflush (s);
+
+  for (sp = &all_streams; *sp != NULL; sp = &(*sp)->next)
+    if (*sp == s)
+      {
+        *sp = s->next;
+        break;
+      }
+
+  close (s->fd);
+  if (s->own_buf)
+    free (s->buf);
+  if (s != stdin && s != stdout)
+    free (s);
+  return retval;
+}
+
+/* Writes out any output buffered in stream S, or in every
+   stream if S is a null pointer.  For a stream buffering input,
+   discards the input and moves the file position back to the
+   first byte not yet read.  Returns 0 if successful, EOF on
+   error. */
+int
+fflush (FILE *s)
+{
+  int retval = 0;
+
+  if (s == NULL)
+    {
+      for (s = all_streams; s != NULL; s = s->next)
+        if (s->writing && fflush (s) == EOF)
+          retval = EOF;
+      return retval;
+    }
+
+  if (s->writing)
+    return flush_output (s) ? 0 : EOF;
+
+  if (s->end > s->pos && s->fd != STDIN_FILENO)
+    seek (s->fd, tell (s->fd) - (s->end - s->pos));
+  s->pos = s->end = s->buf;
+  return 0;
+}
+
+/* Changes stream S's buffering MODE to _IOFBF, _IOLBF, or
+   _IONBF, using the SIZE bytes at BUF as its buffer, or a buffer
+   of our own if BUF is null.  Must be called before any I/O on
+   S.  Returns 0 if successful, nonzero on failure. */
+int
+setvbuf (FILE *s, char *buf, int mode, size_t size)
+{
+  if (mode != _IOFBF && mode != _IOLBF && mode != _IONBF)
+    return -1;
+  if (mode != _IONBF && buf != NULL && size > 0)
+    {
+      if (s->own_buf)
+        free (s->buf);
+      s->buf = buf;
+      s->size = size;
+      s->own_buf = false;
+    }
+  s->mode = mode;
+  s->pos = s->end = s->buf;
+  return 0;
+}
+
+/* Returns the file descriptor underlying stream S. */
+int
+fileno (FILE *s)
+{
+  return s->fd;
+}
+
+/* Returns true if the end of S's file has been reached. */
+int
+feof (FILE *s)
+{
+  return s->eof;
+}
+
+/* Returns true if an error has occurred on S. */
+int
+ferror (FILE *s)
+{
+  return s->error;
+}
+
+/* Writes CNT elements of SIZE bytes each from BUFFER to stream
+   S.  Returns the number of whole elements written. */
+size_t
+fwrite (const void *buffer, size_t size, size_t cnt, FILE *s)
+{
+  const char *p = buffer;
+  size_t total = size * cnt;
+  size_t left = total;
+
+  if (total == 0 || !start_writing (s))
+    return 0;
+
+  if (s->mode == _IONBF)
+    {
+      int n = write (s->fd, p, total);
+      if (n < 0 || (size_t) n != total)
+        {
+          s->error = true;
+          return n < 0 ? 0 : n / size;
+        }
+      return cnt;
+    }
+
+  /* A block at least as big as the buffer goes straight to the
+     file once what is already buffered is written. */
+  if (total >= s->size && s->mode == _IOFBF)
+    {
+      int n;
+
+      if (!flush_output (s))
+        return 0;
+      n = write (s->fd, p, total);
+      if (n < 0 || (size_t) n != total)
+        {
+          s->error = true;
+          return n < 0 ? 0 : n / size;
+        }
+      return cnt;
+    }
+
+  while (left > 0)
+    {
+      size_t room = s->buf + s->size - s->pos;
+      size_t chunk = left < room ? left : room;
+
+      memcpy (s->pos, p, chunk);
+      s->pos += chunk;
+      p += chunk;
+      left -= chunk;
+
+      if (s->pos == s->buf + s->size && !flush_output (s))
+        return (total - left) / size;
+    }
+
+  if (s->mode == _IOLBF && memchr (buffer, '\n', total) != NULL
+      && !flush_output (s))
+    return 0;
+  return cnt;
+}
+
+/* Writes character C to stream S.  Returns C if successful, EOF
+   on error. */
+int
+fputc (int c, FILE *s)
+{
+  if (s->writing && s->mode != _IONBF && s->pos < s->buf + s->size - 1
+      && c != '\n')
+    {
+      /* Fast path: there is room, and no need to flush. */
+      *s->pos++ = c;
+      return (unsigned char) c;
+    }
+  else
+    {
+      char c2 = c;
+      return fwrite (&c2, 1, 1, s) == 1 ? (unsigned char) c : EOF;
+    }
+}
+
+/* Writes string STR to stream S, without a trailing new-line.
+   Returns a nonnegative value if successful, EOF on error. */
+int
+fputs (const char *str, FILE *s)
+{
+  size_t len = strlen (str);
+  return len == 0 || fwrite (str, len, 1, s) == 1 ? 0 : EOF;
+}
+
+/* Auxiliary data for vfprintf_helper(). */
+struct vfprintf_aux
+  {
+    FILE *stream;               /* Output stream. */
+    int char_cnt;               /* Number of characters written. */
+  };
+
+/* Helper function for vfprintf(). */
+static void
+vfprintf_helper (char ch, void *aux_)
+{
+  struct vfprintf_aux *aux = aux_;
+  fputc (ch, aux->stream);
+  aux->char_cnt++;
+}
+
+/* Formats the printf() format specification FORMAT with
+   arguments given in ARGS and writes the output to stream S.
+   Returns the number of characters written. */
+int
+vfprintf (FILE *s, const char *format, va_list args)
+{
+  struct vfprintf_aux aux;
+  int mode = s->mode;
+
+  if (!start_writing (s))
+    return 0;
+
+  /* Gather even an unbuffered stream's output into as few
+     writes as its buffer allows. */
+  if (mode == _IONBF)
+    s->mode = _IOFBF;
+
+  aux.stream = s;
+  aux.char_cnt = 0;
+  __vprintf (format, args, vfprintf_helper, &aux);
+
+  if (mode == _IONBF)
+    {
+      flush_output (s);
+      s->mode = _IONBF;
+    }
+  return aux.char_cnt;
+}
+
+/* Like printf(), but writes output to stream S. */
+int
+fprintf (FILE *s, const char *format, ...)
+{
+  va_list args;
+  int retval;
+
+  va_start (args, format);
+  retval = vfprintf (s, format, args);
+  va_end (args);
+
+  return retval;
+}
+
+/* Reads up to CNT elements of SIZE bytes each from stream S into
+   BUFFER.  Returns the number of whole elements read. */
+size_t
+fread (void *buffer, size_t size, size_t cnt, FILE *s)
+{
+  char *p = buffer;
+  size_t total = size * cnt;
+  size_t done = 0;
+
+  if (total == 0 || !start_reading (s))
+    return 0;
+
+  while (done < total)
+    {
+      size_t avail = s->end - s->pos;
+
+      if (avail == 0)
+        {
+          /* Read a big request straight into the caller's
+             buffer. */
+          if (total - done >= s->size)
+            {
+              int n = read (s->fd, p + done, total - done);
+              if (n <= 0)
+                {
+                  if (n < 0)
+                    s->error = true;
+                  else
+                    s->eof = true;
+                  break;
+                }
+              done += n;
+              continue;
+            }
+          if (!fill (s))
+            break;
+          avail = s->end - s->pos;
+        }
+
+      if (avail > total - done)
+        avail = total - done;
+      memcpy (p + done, s->pos, avail);
+      s->pos += avail;
+      done += avail;
+    }
+  return done / size;
+}
+
+/* Reads and returns one character from stream S, or EOF at end
+   of file or on error. */
+int
+fgetc (FILE *s)
+{
+  if (!s->writing && s->pos < s->end)
+    return (unsigned char) *s->pos++;
+  if (!start_reading (s) || !fill (s))
+    return EOF;
+  return (unsigned char) *s->pos++;
+}
+
+/* Reads a line from stream S into BUF, which has room for SIZE
+   bytes, including the new-line character if there is room for
+   it and a terminating null character.  Returns BUF, or a null
+   pointer if end of file or an error occurs before any
+   characters are read. */
+char *
+fgets (char *buf, int size, FILE *s)
+{
+  char *p = buf;
+
+  if (size <= 0 || !start_reading (s))
+    return NULL;
+
+  while (p < buf + size - 1)
+    {
+      size_t avail, chunk;
+      char *nl;
+
+      if (s->pos == s->end && !fill (s))
+        break;
+
+      avail = s->end - s->pos;
+      chunk = buf + size - 1 - p;
+      if (chunk > avail)
+        chunk = avail;
+      nl = memchr (s->pos, '\n', chunk);
+      if (nl != NULL)
+        chunk = nl - s->pos + 1;
+
+      memcpy (p, s->pos, chunk);
+      s->pos += chunk;
+      p += chunk;
+      if (nl != NULL)
+        break;
+    }
+
+  if (p == buf)
+    return NULL;
+  *p = '\0';
+  return buf;
+}
+
+/* Reads and returns one character from stdin. */
+int
+getchar (void)
+{
+  return fgetc (stdin);
+}
+
+/* Writes out the output buffered in S.  Returns true if
+   successful, false on error. */
+static bool
+flush_output (FILE *s)
+{
+  size_t cnt = s->pos - s->buf;
+
+  s->pos = s->buf;
+  if (cnt > 0)
+    {
+      int n = write (s->fd, s->buf, cnt);
+      if (n < 0 || (size_t) n != cnt)
+        {
+          s->error = true;
+          return false;
+        }
+    }
+  return true;
+}
+
+/* Prepares S for output, dropping any buffered input.  Returns
+   true if successful, false if S is not open for writing. */
+static bool
+start_writing (FILE *s)
+{
+  if (s->writing)
+    return true;
+  if (!s->can_write)
+    {
+      s->error = true;
+      return false;
+    }
+
+  /* Give back the input that was read ahead. */
+  fflush (s);
+  s->writing = true;
+  return true;
+}
+
+/* Prepares S for input, writing out any buffered output.
+   Returns true if successful, false if S is not open for
+   reading or the output cannot be written. */
+static bool
+start_reading (FILE *s)
+{
+  /* Show any prompt before waiting for its answer. */
+  if (s == stdin)
+    fflush (stdout);
+  if (!s->writing)
+    return true;
+  if (!s->can_read)
+    {
+      s->error = true;
+      return false;
+    }
+
+  if (!flush_output (s))
+    return false;
+  s->writing = false;
+  s->pos = s->end = s->buf;
+  return true;
+}
+
+/* Refills S's input buffer with a single read().  Returns true
+   if any bytes were read, false at end of file or on error. */
+static bool
+fill (FILE *s)
+{
+  size_t size = s->mode == _IONBF ? 1 : s->size;
+  int n = read (s->fd, s->buf, size);
+
+  if (n <= 0)
+    {
+      if (n < 0)
+        s->error = true;
+      else
+        s->eof = true;
+      s->pos = s->end = s->buf;
+      return false;
+    }
+  s->pos = s->buf;
+  s->end = s->buf + n;
+  return true;
+}
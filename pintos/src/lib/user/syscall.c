@@ -1,4 +1,5 @@
 #include <syscall.h>
+#include <stdio.h>
 #include "../syscall-nr.h"
 
 /* Invokes syscall NUMBER, passing no arguments, and returns the
@@ -77,6 +78,7 @@ halt (void)
 void
 exit (int status)
 {
+  fflush (NULL);
   syscall1 (SYS_EXIT, status);
   NOT_REACHED ();
 }
@@ -188,3 +190,97 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+void *
+sbrk (intptr_t increment)
+{
+  return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+int
+brk (void *addr)
+{
+  void *old_break = sbrk (0);
+  return sbrk ((char *) addr - (char *) old_break) != (void *) -1 ? 0 : -1;
+}
+
+int
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+dup2 (int old_fd, int new_fd)
+{
+  return syscall2 (SYS_DUP2, old_fd, new_fd);
+}
+
+tid_t
+sys_pthread_create (stub_fun sfun, pthread_fun tfun, const void *arg)
+{
+  return syscall3 (SYS_PT_CREATE, sfun, tfun, arg);
+}
+
+void
+sys_pthread_exit (void)
+{
+  syscall0 (SYS_PT_EXIT);
+  NOT_REACHED ();
+}
+
+tid_t
+sys_pthread_join (tid_t tid)
+{
+  return syscall1 (SYS_PT_JOIN, tid);
+}
+
+tid_t
+get_tid (void)
+{
+  return syscall0 (SYS_GET_TID);
+}
+
+int
+futex_wait (const int *addr, int val)
+{
+  return syscall2 (SYS_FUTEX_WAIT, addr, val);
+}
+
+int
+futex_wake (const int *addr, int cnt)
+{
+  return syscall2 (SYS_FUTEX_WAKE, addr, cnt);
+}
+
+struct aio_ring *
+aio_setup (void)
+{
+  return (struct aio_ring *) syscall0 (SYS_AIO_SETUP);
+}
+
+int
+aio_enter (unsigned to_submit, unsigned min_complete)
+{
+  return syscall2 (SYS_AIO_ENTER, to_submit, min_complete);
+}
+
+int64_t
+clock_ns (void)
+{
+  int64_t ns;
+  syscall1 (SYS_CLOCK_NS, &ns);
+  return ns;
+}
+
+void
+sched_dump (void)
+{
+  syscall0 (SYS_SCHED_DUMP);
+}
+
+void
+block_stats (unsigned long long *read_cnt, unsigned long long *write_cnt)
+{
+  syscall2 (SYS_BLOCK_STATS, read_cnt, write_cnt);
+}
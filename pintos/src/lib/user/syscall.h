@@ -2,12 +2,17 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <debug.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
@@ -46,4 +51,35 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Heap. */
+void *sbrk (intptr_t increment);
+int brk (void *addr);
+
+/* Pipes. */
+int pipe (int fds[2]);
+int dup2 (int old_fd, int new_fd);
+
+/* User threads.  Programs normally use the wrappers in
+   <pthread.h> instead. */
+typedef void (*pthread_fun) (void *);
+typedef void (*stub_fun) (pthread_fun, void *);
+tid_t sys_pthread_create (stub_fun, pthread_fun, const void *);
+void sys_pthread_exit (void) NO_RETURN;
+tid_t sys_pthread_join (tid_t);
+tid_t get_tid (void);
+int futex_wait (const int *addr, int val);
+int futex_wake (const int *addr, int cnt);
+
+/* Asynchronous I/O.  See <aio.h>. */
+struct aio_ring *aio_setup (void);
+int aio_enter (unsigned to_submit, unsigned min_complete);
+
+/* Time. */
+int64_t clock_ns (void);
+
+/* Diagnostics. */
+void sched_dump (void);
+void block_stats (unsigned long long *read_cnt,
+                  unsigned long long *write_cnt);
+
 #endif /* lib/user/syscall.h */
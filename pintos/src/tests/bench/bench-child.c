@@ -0,0 +1,52 @@
+/* Child process for bench-conc.
+   "bench-child w N" writes CHILD_FILE_SIZE bytes to a new file
+   of its own, named cN; "bench-child r N" reads the shared file
+   from start to end.  Either way, exits with status N. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/bench/bench-child.h"
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+
+const char *test_name = "bench-child";
+
+static char buf[CHILD_BLOCK];
+
+int
+main (int argc, const char *argv[])
+{
+  char name[16];
+  int child_idx;
+  int fd, i;
+
+  quiet = true;
+
+  if (argc != 3)
+    fail ("argc must be 3, actually %d", argc);
+  child_idx = atoi (argv[2]);
+
+  if (!strcmp (argv[1], "w"))
+    {
+      snprintf (name, sizeof name, "c%d", child_idx);
+      bench_fill (buf, sizeof buf, child_idx);
+      if (!create (name, 0) || (fd = open (name)) < 2)
+        fail ("create \"%s\" failed", name);
+      for (i = 0; i < CHILD_FILE_SIZE / CHILD_BLOCK; i++)
+        if (write (fd, buf, sizeof buf) != sizeof buf)
+          fail ("write to \"%s\" failed", name);
+    }
+  else
+    {
+      if ((fd = open (CHILD_SHARED)) < 2)
+        fail ("open \"%s\" failed", CHILD_SHARED);
+      for (i = 0; i < CHILD_FILE_SIZE / CHILD_BLOCK; i++)
+        if (read (fd, buf, sizeof buf) != sizeof buf)
+          fail ("read from \"%s\" failed", CHILD_SHARED);
+    }
+  close (fd);
+
+  return child_idx;
+}
@@ -0,0 +1,11 @@
+#ifndef TESTS_BENCH_BENCH_CHILD_H
+#define TESTS_BENCH_BENCH_CHILD_H
+
+/* Bytes each bench-child reads or writes, and in what blocks. */
+#define CHILD_FILE_SIZE (64 * 1024)
+#define CHILD_BLOCK 4096
+
+/* File that every bench-child reads in "r" mode. */
+#define CHILD_SHARED "shared"
+
+#endif /* tests/bench/bench-child.h */
@@ -0,0 +1,59 @@
+/* Concurrency: runs CHILD_CNT copies of bench-child at once,
+   first with each writing a file of its own, then with all of
+   them reading one shared file, and reports the aggregate rate
+   of each phase. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/bench/bench-child.h"
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+
+static char buf[CHILD_BLOCK];
+
+/* Runs CHILD_CNT children with MODE at the same time and waits
+   for all of them. */
+static void
+run_children (const char *mode)
+{
+  pid_t pids[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      char cmd_line[64];
+      snprintf (cmd_line, sizeof cmd_line, "bench-child %s %d", mode, i);
+      if ((pids[i] = exec (cmd_line)) == PID_ERROR)
+        fail ("exec \"%s\" failed", cmd_line);
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (pids[i]) != i)
+      fail ("child %d of \"%s\" failed", i, mode);
+}
+
+void
+test_main (void)
+{
+  unsigned long long ops = CHILD_CNT * (CHILD_FILE_SIZE / CHILD_BLOCK);
+  struct bench b;
+  int i, fd;
+
+  bench_start (&b, "write/%d-procs", CHILD_CNT);
+  run_children ("w");
+  bench_report (&b, ops, (unsigned long long) CHILD_CNT * CHILD_FILE_SIZE);
+
+  bench_fill (buf, sizeof buf, 0);
+  if (!create (CHILD_SHARED, 0) || (fd = open (CHILD_SHARED)) < 2)
+    fail ("create \"%s\" failed", CHILD_SHARED);
+  for (i = 0; i < CHILD_FILE_SIZE / CHILD_BLOCK; i++)
+    if (write (fd, buf, sizeof buf) != sizeof buf)
+      fail ("write failed laying out \"%s\"", CHILD_SHARED);
+  close (fd);
+
+  bench_start (&b, "read-shared/%d-procs", CHILD_CNT);
+  run_children ("r");
+  bench_report (&b, ops, (unsigned long long) CHILD_CNT * CHILD_FILE_SIZE);
+}
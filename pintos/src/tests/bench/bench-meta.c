@@ -0,0 +1,92 @@
+/* Metadata storms: creates, opens and removes many empty files,
+   first all in one wide directory, then at the bottom of a deep
+   chain of directories, so that every operation has to walk the
+   whole path. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define WIDE_CNT 200            /* Files in the wide directory. */
+#define DEEP_DEPTH 8            /* Directories in the deep chain. */
+#define DEEP_CNT 50             /* Files at the bottom of the chain. */
+
+/* Creates, opens and removes CNT files named DIR/fN, reporting
+   each phase under SHAPE. */
+static void
+storm (const char *shape, const char *dir, int cnt)
+{
+  char name[128];
+  struct bench b;
+  int i, fd;
+
+  bench_start (&b, "create/%s", shape);
+  for (i = 0; i < cnt; i++)
+    {
+      snprintf (name, sizeof name, "%s/f%d", dir, i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+  bench_report (&b, cnt, 0);
+
+  bench_start (&b, "open/%s", shape);
+  for (i = 0; i < cnt; i++)
+    {
+      snprintf (name, sizeof name, "%s/f%d", dir, i);
+      if ((fd = open (name)) < 2)
+        fail ("open \"%s\" failed", name);
+      close (fd);
+    }
+  bench_report (&b, cnt, 0);
+
+  bench_start (&b, "remove/%s", shape);
+  for (i = 0; i < cnt; i++)
+    {
+      snprintf (name, sizeof name, "%s/f%d", dir, i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+  bench_report (&b, cnt, 0);
+}
+
+void
+test_main (void)
+{
+  char path[128];
+  size_t len;
+  struct bench b;
+  int i;
+
+  if (!mkdir ("wide"))
+    fail ("mkdir \"wide\" failed");
+  storm ("wide", "wide", WIDE_CNT);
+  if (!remove ("wide"))
+    fail ("remove \"wide\" failed");
+
+  bench_start (&b, "mkdir/deep");
+  len = 0;
+  for (i = 0; i < DEEP_DEPTH; i++)
+    {
+      len += snprintf (path + len, sizeof path - len, "%sd%d",
+                       i > 0 ? "/" : "", i);
+      if (!mkdir (path))
+        fail ("mkdir \"%s\" failed", path);
+    }
+  bench_report (&b, DEEP_DEPTH, 0);
+
+  storm ("deep", path, DEEP_CNT);
+
+  bench_start (&b, "rmdir/deep");
+  for (i = DEEP_DEPTH - 1; i >= 0; i--)
+    {
+      if (!remove (path))
+        fail ("remove \"%s\" failed", path);
+      *strrchr (path, 'd') = '\0';
+      if (i > 0)
+        path[strlen (path) - 1] = '\0';
+    }
+  bench_report (&b, DEEP_DEPTH, 0);
+}
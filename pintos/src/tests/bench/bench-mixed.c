@@ -0,0 +1,67 @@
+/* Mixed metadata workload: each round creates a small file,
+   writes it, reopens it to check its size and read it back,
+   and removes the file created LIVE_CNT rounds earlier.  Every
+   few rounds it also makes a directory and lists the working
+   directory, as a build or a mail spool might. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ROUND_CNT 300           /* Rounds to run. */
+#define LIVE_CNT 20             /* Files kept around. */
+#define FILE_SIZE 1024          /* Bytes in each file. */
+#define DIR_EVERY 10            /* Rounds per mkdir and listing. */
+
+static char buf[FILE_SIZE];
+
+void
+test_main (void)
+{
+  char name[16];
+  struct bench b;
+  int round, fd;
+
+  bench_fill (buf, sizeof buf, 0);
+
+  bench_start (&b, "mixed");
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      snprintf (name, sizeof name, "m%d", round);
+      if (!create (name, 0) || (fd = open (name)) < 2)
+        fail ("create \"%s\" failed", name);
+      if (write (fd, buf, sizeof buf) != sizeof buf)
+        fail ("write to \"%s\" failed", name);
+      close (fd);
+
+      if ((fd = open (name)) < 2)
+        fail ("reopen \"%s\" failed", name);
+      if (filesize (fd) != FILE_SIZE || read (fd, buf, sizeof buf) != sizeof buf)
+        fail ("read back \"%s\" failed", name);
+      close (fd);
+
+      if (round >= LIVE_CNT)
+        {
+          snprintf (name, sizeof name, "m%d", round - LIVE_CNT);
+          if (!remove (name))
+            fail ("remove \"%s\" failed", name);
+        }
+
+      if (round % DIR_EVERY == 0)
+        {
+          char entry[READDIR_MAX_LEN + 1];
+
+          snprintf (name, sizeof name, "dir%d", round / DIR_EVERY);
+          if (!mkdir (name))
+            fail ("mkdir \"%s\" failed", name);
+          if ((fd = open (".")) < 2)
+            fail ("open \".\" failed");
+          while (readdir (fd, entry))
+            continue;
+          close (fd);
+        }
+    }
+  bench_report (&b, ROUND_CNT, 2ULL * ROUND_CNT * FILE_SIZE);
+}
@@ -0,0 +1,64 @@
+/* Random access: at each of several block sizes, reads and then
+   writes OP_CNT blocks at random block-aligned offsets within a
+   FILE_SIZE-byte file. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (512 * 1024)
+#define OP_CNT 1000
+
+static const size_t block_sizes[] = {512, 4096};
+static char buf[4096];
+
+void
+test_main (void)
+{
+  size_t i;
+  int fd;
+
+  /* Lay out the whole file first, so that random writes do not
+     extend it. */
+  bench_fill (buf, sizeof buf, 0);
+  if (!create ("random", 0))
+    fail ("create \"random\" failed");
+  if ((fd = open ("random")) < 2)
+    fail ("open \"random\" failed");
+  for (i = 0; i < FILE_SIZE / sizeof buf; i++)
+    if (write (fd, buf, sizeof buf) != sizeof buf)
+      fail ("write failed laying out \"random\"");
+
+  for (i = 0; i < sizeof block_sizes / sizeof *block_sizes; i++)
+    {
+      size_t block_size = block_sizes[i];
+      size_t block_cnt = FILE_SIZE / block_size;
+      struct bench b;
+      int op;
+
+      bench_start (&b, "read/%zu", block_size);
+      for (op = 0; op < OP_CNT; op++)
+        {
+          seek (fd, random_ulong () % block_cnt * block_size);
+          if (read (fd, buf, block_size) != (int) block_size)
+            fail ("random read of %zu bytes failed", block_size);
+        }
+      bench_report (&b, OP_CNT, (unsigned long long) OP_CNT * block_size);
+
+      bench_start (&b, "write/%zu", block_size);
+      for (op = 0; op < OP_CNT; op++)
+        {
+          seek (fd, random_ulong () % block_cnt * block_size);
+          if (write (fd, buf, block_size) != (int) block_size)
+            fail ("random write of %zu bytes failed", block_size);
+        }
+      bench_report (&b, OP_CNT, (unsigned long long) OP_CNT * block_size);
+    }
+
+  if (filesize (fd) != FILE_SIZE)
+    fail ("\"random\" is %d bytes, expected %d", filesize (fd), FILE_SIZE);
+  close (fd);
+  remove ("random");
+}
@@ -0,0 +1,70 @@
+/* Sequential throughput: at each of several block sizes, writes
+   a fresh FILE_SIZE-byte file from start to end, rewrites it in
+   place, then reads it back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (256 * 1024)
+
+static const size_t block_sizes[] = {64, 512, 4096, 16384};
+static char buf[16384];
+static char check[16384];
+
+/* Writes FILE_SIZE bytes to FD, BLOCK_SIZE bytes at a time,
+   starting at offset 0. */
+static void
+write_file (int fd, size_t block_size)
+{
+  size_t ofs;
+
+  seek (fd, 0);
+  for (ofs = 0; ofs < FILE_SIZE; ofs += block_size)
+    if (write (fd, buf, block_size) != (int) block_size)
+      fail ("write %zu bytes at offset %zu failed", block_size, ofs);
+}
+
+void
+test_main (void)
+{
+  size_t i;
+
+  bench_fill (buf, sizeof buf, 0);
+  for (i = 0; i < sizeof block_sizes / sizeof *block_sizes; i++)
+    {
+      size_t block_size = block_sizes[i];
+      size_t ops = FILE_SIZE / block_size;
+      struct bench b;
+      size_t ofs;
+      int fd;
+
+      if (!create ("seq", 0))
+        fail ("create \"seq\" failed");
+      if ((fd = open ("seq")) < 2)
+        fail ("open \"seq\" failed");
+
+      bench_start (&b, "write/%zu", block_size);
+      write_file (fd, block_size);
+      bench_report (&b, ops, FILE_SIZE);
+
+      bench_start (&b, "rewrite/%zu", block_size);
+      write_file (fd, block_size);
+      bench_report (&b, ops, FILE_SIZE);
+
+      seek (fd, 0);
+      bench_start (&b, "read/%zu", block_size);
+      for (ofs = 0; ofs < FILE_SIZE; ofs += block_size)
+        if (read (fd, check, block_size) != (int) block_size)
+          fail ("read %zu bytes at offset %zu failed", block_size, ofs);
+      bench_report (&b, ops, FILE_SIZE);
+
+      if (memcmp (check, buf, block_size))
+        fail ("data read back at block size %zu differs", block_size);
+      close (fd);
+      if (!remove ("seq"))
+        fail ("remove \"seq\" failed");
+    }
+}
@@ -0,0 +1,63 @@
+/* Measurement and reporting for the file system benchmarks.
+
+   Each measured run is bracketed by bench_start() and
+   bench_report(), which prints a single line of the form
+
+     Bench: PROGRAM NAME ops=N ns=T ops/s=R KB/s=K reads=R writes=W
+
+   where reads and writes count sectors transferred to and from
+   the file system device during the run.  "make bench" collects
+   these lines from every benchmark's output. */
+
+#include "tests/bench/bench.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+/* Starts measuring run B, naming it with printf-style FORMAT. */
+void
+bench_start (struct bench *b, const char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  vsnprintf (b->name, sizeof b->name, format, args);
+  va_end (args);
+
+  block_stats (&b->read_cnt, &b->write_cnt);
+  b->start_ns = clock_ns ();
+}
+
+/* Ends run B, which carried out OPS operations that transferred
+   BYTES bytes of file data (0 if the operations are not reads or
+   writes), and reports its rates. */
+void
+bench_report (struct bench *b, unsigned long long ops,
+              unsigned long long bytes)
+{
+  int64_t ns = clock_ns () - b->start_ns;
+  unsigned long long read_cnt, write_cnt;
+
+  block_stats (&read_cnt, &write_cnt);
+  if (ns <= 0)
+    ns = 1;
+
+  printf ("Bench: %s %s ops=%llu ns=%lld ops/s=%llu KB/s=%llu "
+          "reads=%llu writes=%llu\n",
+          test_name, b->name, ops, ns, ops * 1000000000 / ns,
+          bytes * 1000000000 / 1024 / ns,
+          read_cnt - b->read_cnt, write_cnt - b->write_cnt);
+}
+
+/* Fills the SIZE bytes at P with a pattern that depends on
+   SEED, so that data written can be checked when read back. */
+void
+bench_fill (void *p_, size_t size, unsigned seed)
+{
+  uint8_t *p = p_;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    p[i] = (uint8_t) (i * 31 + seed);
+}
@@ -0,0 +1,24 @@
+#ifndef TESTS_BENCH_BENCH_H
+#define TESTS_BENCH_BENCH_H
+
+#include <debug.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* One measured run of a benchmark. */
+struct bench
+  {
+    char name[32];                  /* What is being measured. */
+    int64_t start_ns;               /* clock_ns() at start. */
+    unsigned long long read_cnt;    /* Sectors read before start. */
+    unsigned long long write_cnt;   /* Sectors written before start. */
+  };
+
+void bench_start (struct bench *, const char *format, ...)
+  PRINTF_FORMAT (2, 3);
+void bench_report (struct bench *, unsigned long long ops,
+                   unsigned long long bytes);
+
+void bench_fill (void *, size_t size, unsigned seed);
+
+#endif /* tests/bench/bench.h */
@@ -0,0 +1,216 @@
+/* Test program and microbenchmark for lib/kernel/bitmap.c.
+
+   Checks the word-at-a-time bitmap_count(), bitmap_contains(),
+   bitmap_scan(), and bitmap_set_multiple() against simple
+   bit-by-bit reference versions on random bitmaps, then times
+   both versions on a large, fragmented bitmap.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/test.h"
+#include "threads/tsc.h"
+
+/* Largest bitmap used for the correctness checks. */
+#define MAX_BITS 300
+
+/* Size of the bitmap used for benchmarking. */
+#define BENCH_BITS (1 << 16)
+
+/* Number of times each benchmark is repeated. */
+#define BENCH_REPEAT 16
+
+static void randomize (struct bitmap *, int density);
+static void verify (struct bitmap *);
+static void benchmark (void);
+
+static size_t ref_count (const struct bitmap *, size_t start, size_t cnt,
+                         bool value);
+static bool ref_contains (const struct bitmap *, size_t start, size_t cnt,
+                          bool value);
+static size_t ref_scan (const struct bitmap *, size_t start, size_t cnt,
+                        bool value);
+
+/* Test bitmap implementation. */
+void
+test (void)
+{
+  size_t bit_cnt;
+
+  printf ("testing various size bitmaps:");
+  for (bit_cnt = 0; bit_cnt <= MAX_BITS; bit_cnt = bit_cnt * 4 / 3 + 1)
+    {
+      struct bitmap *b = bitmap_create (bit_cnt);
+      int density;
+
+      ASSERT (b != NULL);
+      printf (" %zu", bit_cnt);
+      for (density = 0; density <= 16; density += 4)
+        {
+          randomize (b, density);
+          verify (b);
+        }
+      bitmap_destroy (b);
+    }
+  printf (" done\n");
+
+  benchmark ();
+  printf ("bitmap: PASS\n");
+}
+
+/* Sets each bit in B with probability DENSITY/16, using
+   bitmap_set_multiple() on random runs, and checks the result
+   bit by bit. */
+static void
+randomize (struct bitmap *b, int density)
+{
+  size_t size = bitmap_size (b);
+  size_t i = 0;
+
+  while (i < size)
+    {
+      size_t cnt = 1 + random_ulong () % (size - i < 70 ? size - i : 70);
+      bool value = (int) (random_ulong () % 16) < density;
+      size_t j;
+
+      bitmap_set_multiple (b, i, cnt, value);
+      for (j = 0; j < cnt; j++)
+        ASSERT (bitmap_test (b, i + j) == value);
+      i += cnt;
+    }
+}
+
+/* Checks every bitmap query on B against the reference
+   implementation, for every start and length. */
+static void
+verify (struct bitmap *b)
+{
+  size_t size = bitmap_size (b);
+  size_t start, cnt;
+  int value;
+
+  for (value = 0; value <= 1; value++)
+    for (start = 0; start <= size; start++)
+      for (cnt = 0; start + cnt <= size; cnt++)
+        {
+          ASSERT (bitmap_count (b, start, cnt, value)
+                  == ref_count (b, start, cnt, value));
+          ASSERT (bitmap_contains (b, start, cnt, value)
+                  == ref_contains (b, start, cnt, value));
+          ASSERT (bitmap_scan (b, start, cnt, value)
+                  == ref_scan (b, start, cnt, value));
+        }
+}
+
+/* Times the reference and word-at-a-time scans and counts on a
+   large bitmap that is mostly full, with scattered free runs,
+   roughly like a fragmented free map. */
+static void
+benchmark (void)
+{
+  static const size_t scan_cnts[] = {1, 8, 64};
+  struct bitmap *b = bitmap_create (BENCH_BITS);
+  size_t i;
+
+  ASSERT (b != NULL);
+  bitmap_set_all (b, true);
+  for (i = 0; i < BENCH_BITS / 64; i++)
+    {
+      size_t start = random_ulong () % BENCH_BITS;
+      size_t cnt = 1 + random_ulong () % 32;
+      if (start + cnt <= BENCH_BITS)
+        bitmap_set_multiple (b, start, cnt, false);
+    }
+
+  for (i = 0; i < sizeof scan_cnts / sizeof *scan_cnts; i++)
+    {
+      uint64_t start, ref_cycles, new_cycles;
+      size_t ref_idx = 0, new_idx = 0;
+      int repeat;
+
+      start = rdtsc ();
+      for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+        ref_idx = ref_scan (b, 0, scan_cnts[i], false);
+      ref_cycles = rdtsc () - start;
+
+      start = rdtsc ();
+      for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+        new_idx = bitmap_scan (b, 0, scan_cnts[i], false);
+      new_cycles = rdtsc () - start;
+
+      ASSERT (ref_idx == new_idx);
+      printf ("scan %zu of %d bits: %llu cycles old, %llu cycles new\n",
+              scan_cnts[i], BENCH_BITS, ref_cycles / BENCH_REPEAT,
+              new_cycles / BENCH_REPEAT);
+    }
+
+  {
+    uint64_t start, ref_cycles, new_cycles;
+    size_t ref_cnt = 0, new_cnt = 0;
+    int repeat;
+
+    start = rdtsc ();
+    for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+      ref_cnt = ref_count (b, 0, BENCH_BITS, false);
+    ref_cycles = rdtsc () - start;
+
+    start = rdtsc ();
+    for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+      new_cnt = bitmap_count (b, 0, BENCH_BITS, false);
+    new_cycles = rdtsc () - start;
+
+    ASSERT (ref_cnt == new_cnt);
+    printf ("count of %d bits: %llu cycles old, %llu cycles new\n",
+            BENCH_BITS, ref_cycles / BENCH_REPEAT, new_cycles / BENCH_REPEAT);
+  }
+
+  bitmap_destroy (b);
+}
+
+/* Reference bitmap_count(), one bit at a time. */
+static size_t
+ref_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
+{
+  size_t i, value_cnt = 0;
+
+  for (i = 0; i < cnt; i++)
+    if (bitmap_test (b, start + i) == value)
+      value_cnt++;
+  return value_cnt;
+}
+
+/* Reference bitmap_contains(), one bit at a time. */
+static bool
+ref_contains (const struct bitmap *b, size_t start, size_t cnt, bool value)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    if (bitmap_test (b, start + i) == value)
+      return true;
+  return false;
+}
+
+/* Reference bitmap_scan(), trying every starting index. */
+static size_t
+ref_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
+{
+  size_t size = bitmap_size (b);
+
+  if (cnt <= size)
+    {
+      size_t last = size - cnt;
+      size_t i;
+      for (i = start; i <= last; i++)
+        if (!ref_contains (b, i, cnt, !value))
+          return i;
+    }
+  return BITMAP_ERROR;
+}
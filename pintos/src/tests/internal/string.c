@@ -0,0 +1,229 @@
+/* Test program and microbenchmark for the memory functions in
+   lib/string.c.
+
+   Checks memcpy(), memmove(), memset(), and memcmp() against
+   simple byte-at-a-time reference versions for every small size
+   and every combination of source and destination alignment,
+   including overlapping memmove()s in both directions.  Then
+   reports the bytes per 100 cycles achieved by each function
+   across a range of block sizes.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/test.h"
+#include "threads/tsc.h"
+
+/* Largest block size checked for correctness. */
+#define MAX_SIZE 80
+
+/* Size of the buffers.  Leaves room for any alignment and for
+   overlapping moves of up to MAX_SIZE bytes. */
+#define BUF_SIZE (MAX_SIZE * 3)
+
+/* Largest block size benchmarked, a page. */
+#define BENCH_MAX 4096
+
+/* Number of times each benchmark is repeated. */
+#define BENCH_REPEAT 64
+
+static unsigned char src_buf[BUF_SIZE];
+static unsigned char dst_buf[BUF_SIZE];
+static unsigned char ref_buf[BUF_SIZE];
+
+static void fill_random (unsigned char *, size_t);
+static void test_copy (void);
+static void test_move (void);
+static void test_set (void);
+static void test_cmp (void);
+static void benchmark (void);
+
+/* Test memory functions. */
+void
+test (void)
+{
+  test_copy ();
+  test_move ();
+  test_set ();
+  test_cmp ();
+  benchmark ();
+  printf ("string: PASS\n");
+}
+
+/* Fills the CNT bytes at P with random values. */
+static void
+fill_random (unsigned char *p, size_t cnt)
+{
+  random_bytes (p, cnt);
+}
+
+/* Checks memcpy() for every size and alignment. */
+static void
+test_copy (void)
+{
+  size_t size, src_ofs, dst_ofs, i;
+
+  printf ("testing memcpy...");
+  for (size = 0; size <= MAX_SIZE; size++)
+    for (src_ofs = 0; src_ofs < 4; src_ofs++)
+      for (dst_ofs = 0; dst_ofs < 4; dst_ofs++)
+        {
+          fill_random (src_buf, sizeof src_buf);
+          fill_random (dst_buf, sizeof dst_buf);
+          memcpy (ref_buf, dst_buf, sizeof ref_buf);
+          for (i = 0; i < size; i++)
+            ref_buf[dst_ofs + i] = src_buf[src_ofs + i];
+
+          ASSERT (memcpy (dst_buf + dst_ofs, src_buf + src_ofs, size)
+                  == dst_buf + dst_ofs);
+          for (i = 0; i < sizeof dst_buf; i++)
+            ASSERT (dst_buf[i] == ref_buf[i]);
+        }
+  printf (" done\n");
+}
+
+/* Checks memmove() for every size and every overlap in both
+   directions. */
+static void
+test_move (void)
+{
+  size_t size, src_ofs, dst_ofs, i;
+
+  printf ("testing memmove...");
+  for (size = 0; size <= MAX_SIZE; size++)
+    for (src_ofs = 0; src_ofs <= MAX_SIZE + 4; src_ofs += 3)
+      for (dst_ofs = 0; dst_ofs <= MAX_SIZE + 4; dst_ofs++)
+        {
+          fill_random (dst_buf, sizeof dst_buf);
+          memcpy (ref_buf, dst_buf, sizeof ref_buf);
+          for (i = 0; i < size; i++)
+            src_buf[i] = ref_buf[src_ofs + i];
+          for (i = 0; i < size; i++)
+            ref_buf[dst_ofs + i] = src_buf[i];
+
+          ASSERT (memmove (dst_buf + dst_ofs, dst_buf + src_ofs, size)
+                  == dst_buf + dst_ofs);
+          for (i = 0; i < sizeof dst_buf; i++)
+            ASSERT (dst_buf[i] == ref_buf[i]);
+        }
+  printf (" done\n");
+}
+
+/* Checks memset() for every size and alignment. */
+static void
+test_set (void)
+{
+  size_t size, dst_ofs, i;
+
+  printf ("testing memset...");
+  for (size = 0; size <= MAX_SIZE; size++)
+    for (dst_ofs = 0; dst_ofs < 4; dst_ofs++)
+      {
+        int value = random_ulong () % 512 - 128;
+
+        fill_random (dst_buf, sizeof dst_buf);
+        memcpy (ref_buf, dst_buf, sizeof ref_buf);
+        for (i = 0; i < size; i++)
+          ref_buf[dst_ofs + i] = value;
+
+        ASSERT (memset (dst_buf + dst_ofs, value, size) == dst_buf + dst_ofs);
+        for (i = 0; i < sizeof dst_buf; i++)
+          ASSERT (dst_buf[i] == ref_buf[i]);
+      }
+  printf (" done\n");
+}
+
+/* Checks memcmp() on equal blocks and on blocks that differ in
+   a single byte at each position, in both directions. */
+static void
+test_cmp (void)
+{
+  size_t size, ofs, diff;
+
+  printf ("testing memcmp...");
+  for (size = 0; size <= MAX_SIZE; size++)
+    for (ofs = 0; ofs < 4; ofs++)
+      {
+        fill_random (src_buf, sizeof src_buf);
+        memcpy (dst_buf + ofs, src_buf, size);
+        ASSERT (memcmp (src_buf, dst_buf + ofs, size) == 0);
+
+        for (diff = 0; diff < size; diff++)
+          {
+            unsigned char saved = dst_buf[ofs + diff];
+
+            dst_buf[ofs + diff] = src_buf[diff] ^ 0x80;
+            if (src_buf[diff] > dst_buf[ofs + diff])
+              {
+                ASSERT (memcmp (src_buf, dst_buf + ofs, size) > 0);
+                ASSERT (memcmp (dst_buf + ofs, src_buf, size) < 0);
+              }
+            else
+              {
+                ASSERT (memcmp (src_buf, dst_buf + ofs, size) < 0);
+                ASSERT (memcmp (dst_buf + ofs, src_buf, size) > 0);
+              }
+            dst_buf[ofs + diff] = saved;
+          }
+      }
+  printf (" done\n");
+}
+
+/* Prints the throughput of CNT bytes processed BENCH_REPEAT
+   times in CYCLES cycles, in bytes per 100 cycles. */
+static void
+print_rate (const char *name, size_t cnt, uint64_t cycles)
+{
+  uint64_t bytes = (uint64_t) cnt * BENCH_REPEAT * 100;
+
+  printf (" %s %llu", name, cycles != 0 ? bytes / cycles : 0);
+}
+
+/* Measures each function on page-aligned blocks of doubling
+   size, up to a page. */
+static void
+benchmark (void)
+{
+  static unsigned char a[BENCH_MAX] __attribute__ ((aligned (4096)));
+  static unsigned char b[BENCH_MAX] __attribute__ ((aligned (4096)));
+  size_t size;
+
+  printf ("bytes per 100 cycles:\n");
+  for (size = 16; size <= BENCH_MAX; size *= 2)
+    {
+      uint64_t start;
+      int repeat;
+
+      printf ("  %4zu:", size);
+
+      start = rdtsc ();
+      for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+        memset (a, repeat, size);
+      print_rate ("memset", size, rdtsc () - start);
+
+      start = rdtsc ();
+      for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+        memcpy (b, a, size);
+      print_rate ("memcpy", size, rdtsc () - start);
+
+      start = rdtsc ();
+      for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+        memmove (a + 1, a, size - 1);
+      print_rate ("memmove", size, rdtsc () - start);
+
+      memcpy (b, a, size);
+      start = rdtsc ();
+      for (repeat = 0; repeat < BENCH_REPEAT; repeat++)
+        ASSERT (memcmp (a, b, size) == 0);
+      print_rate ("memcmp", size, rdtsc () - start);
+
+      printf ("\n");
+    }
+}
@@ -0,0 +1,60 @@
+/* Measures the cost of acquiring and releasing a lock, first
+   uncontended, then with THREAD_CNT threads of equal priority
+   that yield while holding the lock, so that every acquisition
+   after the first finds it held and has to block. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+
+#define UNCONTENDED_CNT 100000
+#define THREAD_CNT 4
+#define CONTENDED_CNT 2000      /* Per thread. */
+
+static struct lock lock;
+static struct semaphore done;
+
+static void
+contender (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < CONTENDED_CNT; i++)
+    {
+      lock_acquire (&lock);
+      thread_yield ();
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
+
+void
+test_bench_lock (void)
+{
+  uint64_t start;
+  int i;
+
+  lock_init (&lock);
+  sema_init (&done, 0);
+
+  start = rdtsc ();
+  for (i = 0; i < UNCONTENDED_CNT; i++)
+    {
+      lock_acquire (&lock);
+      lock_release (&lock);
+    }
+  bench_ops ("uncontended", UNCONTENDED_CNT, rdtsc () - start);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "contender %d", i);
+      thread_create (name, thread_get_priority (), contender, NULL);
+    }
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  bench_ops ("contended", THREAD_CNT * CONTENDED_CNT, rdtsc () - start);
+}
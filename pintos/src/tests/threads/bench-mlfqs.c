@@ -0,0 +1,81 @@
+/* Measures fairness under the MLFQS scheduler with many threads.
+   THREAD_CNT threads, all with nice 0, spin for RUN_SECS seconds
+   counting the ticks in which they ran, as in mlfqs-fair-20.
+   Reports the smallest and largest share and Jain's fairness
+   index, (sum x)^2 / (n * sum x^2), which is 1 when every thread
+   gets the same number of ticks and 1/n when one gets them all. */
+
+#include <limits.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 32
+#define RUN_SECS 10
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+  };
+
+static void load_thread (void *aux);
+
+void
+test_bench_mlfqs (void)
+{
+  static struct thread_info info[THREAD_CNT];
+  int64_t start_time, sum = 0, sum_sq = 0;
+  int min = INT_MAX, max = 0;
+  int i;
+
+  ASSERT (thread_mlfqs);
+
+  thread_set_nice (-20);
+  start_time = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+
+      info[i].start_time = start_time;
+      info[i].tick_count = 0;
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, &info[i]);
+    }
+  timer_sleep ((RUN_SECS + 10) * TIMER_FREQ);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      int ticks = info[i].tick_count;
+
+      sum += ticks;
+      sum_sq += (int64_t) ticks * ticks;
+      if (ticks < min)
+        min = ticks;
+      if (ticks > max)
+        max = ticks;
+    }
+  bench_result ("mlfqs-fair threads=%d ticks=%lld share-min=%d share-max=%d "
+                "jain-x1000=%lld", THREAD_CNT, sum, min, max,
+                sum_sq != 0 ? sum * sum * 1000 / (THREAD_CNT * sum_sq) : 0);
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 5 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + RUN_SECS * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,53 @@
+/* Measures how late sleeping threads wake up: sleeps SAMPLE_CNT
+   times for each of several durations, whole ticks with
+   timer_sleep() and sub-tick ones with timer_usleep(), and
+   reports how much longer than requested each sleep took. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+#include "threads/thread.h"
+
+#define SAMPLE_CNT 20
+
+#define TICK_NS (1000000000 / TIMER_FREQ)
+
+/* Sleeps SAMPLE_CNT times with SLEEP (AMOUNT), which should take
+   EXPECTED_NS, and reports lateness under NAME. */
+static void
+measure (const char *name, void (*sleep) (int64_t), int64_t amount,
+         int64_t expected_ns)
+{
+  int64_t min = INT64_MAX, max = INT64_MIN, total = 0;
+  int i;
+
+  for (i = 0; i < SAMPLE_CNT; i++)
+    {
+      int64_t start, late;
+
+      /* Start just after a tick, so that whole-tick sleeps take
+         whole ticks. */
+      timer_sleep (1);
+      start = timer_ns ();
+      sleep (amount);
+      late = timer_ns () - start - expected_ns;
+
+      total += late;
+      if (late < min)
+        min = late;
+      if (late > max)
+        max = late;
+    }
+  bench_result ("%s/%lld samples=%d late-min-ns=%lld late-mean-ns=%lld "
+                "late-max-ns=%lld", name, amount, SAMPLE_CNT, min,
+                total / SAMPLE_CNT, max);
+}
+
+void
+test_bench_sleep (void)
+{
+  measure ("timer_sleep", timer_sleep, 1, TICK_NS);
+  measure ("timer_sleep", timer_sleep, 5, 5 * TICK_NS);
+  measure ("timer_usleep", timer_usleep, 200, 200 * 1000);
+  measure ("timer_usleep", timer_usleep, 2000, 2000 * 1000);
+}
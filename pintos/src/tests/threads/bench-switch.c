@@ -0,0 +1,44 @@
+/* Measures the cost of a context switch by bouncing control
+   between two threads of equal priority through a pair of
+   semaphores.  Each round trip is two switches. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+
+#define ROUND_CNT 10000
+
+static struct semaphore ping, pong;
+
+static void
+ponger (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+}
+
+void
+test_bench_switch (void)
+{
+  uint64_t start;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  thread_create ("ponger", thread_get_priority (), ponger, NULL);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  bench_ops ("sema-switch", 2 * ROUND_CNT, rdtsc () - start);
+}
@@ -0,0 +1,58 @@
+/* Measures thread_create() and thread_exit() throughput with
+   threads that exit as soon as they start: first with threads
+   of higher priority than the creator, each of which runs to
+   completion before thread_create() returns, then with batches
+   of threads of the creator's priority that run once it blocks. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+
+#define THREAD_CNT 1000
+#define BATCH_SIZE 50
+
+static struct semaphore done;
+
+static void
+exiter (void *aux UNUSED)
+{
+  sema_up (&done);
+}
+
+/* Creates a thread with PRIORITY that exits right away. */
+static void
+create (int priority)
+{
+  if (thread_create ("exiter", priority, exiter, NULL) == TID_ERROR)
+    fail ("thread_create failed");
+}
+
+void
+test_bench_thread (void)
+{
+  uint64_t start;
+  int i, j;
+
+  ASSERT (thread_get_priority () < PRI_MAX);
+  sema_init (&done, 0);
+
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      create (thread_get_priority () + 1);
+      sema_down (&done);
+    }
+  bench_ops ("create-exit/preempt", THREAD_CNT, rdtsc () - start);
+
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i += BATCH_SIZE)
+    {
+      for (j = 0; j < BATCH_SIZE; j++)
+        create (thread_get_priority ());
+      for (j = 0; j < BATCH_SIZE; j++)
+        sema_down (&done);
+    }
+  bench_ops ("create-exit/batch", THREAD_CNT, rdtsc () - start);
+}
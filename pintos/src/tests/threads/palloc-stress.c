@@ -0,0 +1,148 @@
+/* Allocates and frees kernel pages in random order with a mix
+   of page counts, checking that no two live allocations
+   overlap, and reports the distribution of allocation latency
+   in TSC cycles.  When the pool runs out, frees other live
+   allocations until the request fits, so the test does not
+   depend on the size of the pool.  Finally checks that once
+   everything has been freed, a large block can be allocated
+   again, which fails if freed pages were not merged back
+   together. */
+
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/tsc.h"
+#include "threads/vaddr.h"
+
+/* Number of allocations live at once. */
+#define SLOT_CNT 64
+
+/* Number of allocate/free rounds. */
+#define ROUND_CNT 4096
+
+/* Latency histogram buckets, by floor(log2(cycles)). */
+#define BUCKET_CNT 32
+
+/* A live allocation. */
+struct slot
+  {
+    uint8_t *pages;             /* First page, or null if free. */
+    size_t page_cnt;            /* Number of pages. */
+    uint8_t tag;                /* Byte written to every page. */
+  };
+
+static struct slot slots[SLOT_CNT];
+static unsigned latency_hist[BUCKET_CNT];
+
+/* Frees the allocation in S after checking that none of its
+   pages were overwritten by another allocation. */
+static void
+release (struct slot *s)
+{
+  size_t i;
+
+  for (i = 0; i < s->page_cnt; i++)
+    if (s->pages[i * PGSIZE] != s->tag
+        || s->pages[i * PGSIZE + PGSIZE - 1] != s->tag)
+      fail ("page %zu of a %zu-page block was overwritten", i, s->page_cnt);
+  palloc_free_multiple (s->pages, s->page_cnt);
+  s->pages = NULL;
+}
+
+/* Returns a live slot other than EXCEPT, starting the search at
+   a random slot, or a null pointer if there is none. */
+static struct slot *
+other_live_slot (const struct slot *except)
+{
+  size_t start = random_ulong () % SLOT_CNT;
+  size_t i;
+
+  for (i = 0; i < SLOT_CNT; i++)
+    {
+      struct slot *s = &slots[(start + i) % SLOT_CNT];
+      if (s->pages != NULL && s != except)
+        return s;
+    }
+  return NULL;
+}
+
+void
+test_palloc_stress (void)
+{
+  static const size_t page_cnts[] = {1, 1, 1, 1, 2, 2, 3, 4, 5, 8, 13, 16};
+  uint64_t total = 0;
+  unsigned evict_cnt = 0;
+  size_t big_cnt;
+  void *big;
+  int round, i;
+
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      struct slot *s = &slots[random_ulong () % SLOT_CNT];
+      uint64_t start, cycles;
+      size_t j;
+
+      if (s->pages != NULL)
+        release (s);
+
+      s->page_cnt = page_cnts[random_ulong () % (sizeof page_cnts
+                                                 / sizeof *page_cnts)];
+      for (;;)
+        {
+          struct slot *victim;
+
+          start = rdtsc ();
+          s->pages = palloc_get_multiple (0, s->page_cnt);
+          cycles = rdtsc () - start;
+          if (s->pages != NULL)
+            break;
+
+          /* Out of memory: make room and try again. */
+          victim = other_live_slot (s);
+          if (victim == NULL)
+            fail ("out of memory allocating %zu pages "
+                  "with nothing else allocated", s->page_cnt);
+          release (victim);
+          evict_cnt++;
+        }
+
+      total += cycles;
+      if (cycles >> 32)
+        latency_hist[BUCKET_CNT - 1]++;
+      else
+        latency_hist[31 - __builtin_clz ((uint32_t) cycles | 1)]++;
+
+      s->tag = round;
+      for (j = 0; j < s->page_cnt; j++)
+        {
+          s->pages[j * PGSIZE] = s->tag;
+          s->pages[j * PGSIZE + PGSIZE - 1] = s->tag;
+        }
+    }
+
+  for (i = 0; i < SLOT_CNT; i++)
+    if (slots[i].pages != NULL)
+      release (&slots[i]);
+
+  msg ("%u allocations freed to make room", evict_cnt);
+  msg ("allocation latency, %d allocations, mean %llu cycles:",
+       ROUND_CNT, total / ROUND_CNT);
+  for (i = 0; i < BUCKET_CNT; i++)
+    if (latency_hist[i] != 0)
+      msg ("  [2^%d, 2^%d) cycles: %u", i, i + 1, latency_hist[i]);
+
+  /* Everything is free again, so blocks must have merged. */
+  for (big_cnt = 256; big_cnt > 0; big_cnt /= 2)
+    {
+      big = palloc_get_multiple (0, big_cnt);
+      if (big != NULL)
+        break;
+    }
+  if (big_cnt < 64)
+    fail ("largest block after freeing everything is %zu pages", big_cnt);
+  palloc_free_multiple (big, big_cnt);
+
+  pass ();
+}
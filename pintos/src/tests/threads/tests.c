@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <string.h>
 #include <stdio.h>
+#include "devices/timer.h"
 
 struct test
   {
@@ -38,6 +39,12 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"palloc-stress", test_palloc_stress},
+    {"bench-switch", test_bench_switch},
+    {"bench-lock", test_bench_lock},
+    {"bench-thread", test_bench_thread},
+    {"bench-sleep", test_bench_sleep},
+    {"bench-mlfqs", test_bench_mlfqs},
   };
 
 static const char *test_name;
@@ -100,3 +107,31 @@ pass (void)
   printf ("(%s) PASS\n", test_name);
 }
 
+/* Prints a benchmark result line
+     Bench: TEST RESULT
+   for "make bench" to collect, where RESULT is FORMAT formatted
+   as if with printf().  By convention RESULT is a name followed
+   by KEY=VALUE pairs. */
+void
+bench_result (const char *format, ...)
+{
+  va_list args;
+
+  printf ("Bench: %s ", test_name);
+  va_start (args, format);
+  vprintf (format, args);
+  va_end (args);
+  putchar ('\n');
+}
+
+/* Reports benchmark NAME, which carried out OPS operations in
+   CYCLES TSC cycles, with the time and cost of each operation. */
+void
+bench_ops (const char *name, unsigned ops, uint64_t cycles)
+{
+  int64_t ns = timer_tsc_to_ns (cycles);
+
+  bench_result ("%s ops=%u ns=%lld ns/op=%lld cycles/op=%llu", name, ops,
+                ns, ns / ops, cycles / ops);
+}
+
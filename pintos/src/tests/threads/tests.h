@@ -1,6 +1,8 @@
 #ifndef TESTS_THREADS_TESTS_H
 #define TESTS_THREADS_TESTS_H
 
+#include <stdint.h>
+
 void run_test (const char *);
 
 typedef void test_func (void);
@@ -32,10 +34,19 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_palloc_stress;
+extern test_func test_bench_switch;
+extern test_func test_bench_lock;
+extern test_func test_bench_thread;
+extern test_func test_bench_sleep;
+extern test_func test_bench_mlfqs;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
 void pass (void);
 
+void bench_result (const char *, ...);
+void bench_ops (const char *name, unsigned ops, uint64_t cycles);
+
 #endif /* tests/threads/tests.h */
 
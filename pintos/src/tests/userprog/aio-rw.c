@@ -0,0 +1,90 @@
+/* Writes a file with a batch of asynchronous writes, reads it
+   back with a batch of asynchronous reads that also includes a
+   request on a bad fd, and checks every completion. */
+
+#include <aio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK_CNT 8
+#define CHUNK_SIZE 2048
+#define BAD_TAG 99
+
+static struct aio_ring *ring;
+static char data[CHUNK_CNT * CHUNK_SIZE];
+
+/* Queues a request on the submission ring. */
+static void
+queue (enum aio_op op, int fd, void *buffer, size_t size, unsigned offset,
+       unsigned tag)
+{
+  struct aio_sqe *sqe = &ring->sqes[ring->sq_tail % AIO_ENTRIES];
+
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buffer = buffer;
+  sqe->size = size;
+  sqe->offset = offset;
+  sqe->user_data = tag;
+  ring->sq_tail++;
+}
+
+/* Submits every queued request, waits for CNT completions, and
+   checks that request BAD_TAG, if any, failed and the others
+   each transferred a whole chunk. */
+static void
+complete (unsigned cnt)
+{
+  unsigned seen = 0;
+
+  if (aio_enter (cnt, cnt) != (int) cnt)
+    fail ("aio_enter did not take %u requests", cnt);
+  if (ring->cq_tail - ring->cq_head != cnt)
+    fail ("%u completions instead of %u", ring->cq_tail - ring->cq_head, cnt);
+  while (ring->cq_head != ring->cq_tail)
+    {
+      struct aio_cqe *cqe = &ring->cqes[ring->cq_head++ % AIO_ENTRIES];
+      int expected = cqe->user_data == BAD_TAG ? -1 : CHUNK_SIZE;
+
+      if (cqe->result != expected)
+        fail ("request %u returned %d", cqe->user_data, cqe->result);
+      if (seen & (1u << (cqe->user_data % 32)))
+        fail ("request %u completed twice", cqe->user_data);
+      seen |= 1u << (cqe->user_data % 32);
+    }
+}
+
+void
+test_main (void)
+{
+  int fd, i;
+
+  CHECK ((ring = aio_setup ()) != NULL, "aio_setup");
+  CHECK (create ("aio.dat", 0), "create \"aio.dat\"");
+  CHECK ((fd = open ("aio.dat")) > 1, "open \"aio.dat\"");
+
+  for (i = 0; i < CHUNK_CNT; i++)
+    {
+      memset (data + i * CHUNK_SIZE, 'a' + i, CHUNK_SIZE);
+      queue (AIO_WRITE, fd, data + i * CHUNK_SIZE, CHUNK_SIZE,
+             i * CHUNK_SIZE, i);
+    }
+  complete (CHUNK_CNT);
+  msg ("asynchronous writes");
+  CHECK (filesize (fd) == sizeof data, "file size");
+
+  memset (data, 0, sizeof data);
+  for (i = CHUNK_CNT - 1; i >= 0; i--)
+    queue (AIO_READ, fd, data + i * CHUNK_SIZE, CHUNK_SIZE, i * CHUNK_SIZE, i);
+  queue (AIO_READ, 1234, data, CHUNK_SIZE, 0, BAD_TAG);
+  complete (CHUNK_CNT + 1);
+  msg ("asynchronous reads");
+
+  for (i = 0; i < (int) sizeof data; i++)
+    if (data[i] != 'a' + i / CHUNK_SIZE)
+      fail ("byte %d is '%c', not '%c'", i, data[i], 'a' + i / CHUNK_SIZE);
+  msg ("data read back correctly");
+  close (fd);
+}
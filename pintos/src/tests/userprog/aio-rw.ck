@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-rw) begin
+(aio-rw) aio_setup
+(aio-rw) create "aio.dat"
+(aio-rw) open "aio.dat"
+(aio-rw) asynchronous writes
+(aio-rw) file size
+(aio-rw) asynchronous reads
+(aio-rw) data read back correctly
+(aio-rw) end
+aio-rw: exit(0)
+EOF
+pass;
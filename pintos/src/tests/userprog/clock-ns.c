@@ -0,0 +1,41 @@
+/* Reads the high-resolution clock many times in a row, checking
+   that it never goes backward and that it can tell apart times
+   much closer together than a timer tick, then checks that it
+   advances across a stretch of busy work. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define READ_CNT 1000
+
+/* One timer tick at the kernel's TIMER_FREQ of 100 Hz. */
+#define TICK_NS 10000000
+
+void
+test_main (void)
+{
+  int64_t prev, now, min_step = INT64_MAX;
+  volatile int sink = 0;
+  int i;
+
+  prev = clock_ns ();
+  for (i = 0; i < READ_CNT; i++)
+    {
+      now = clock_ns ();
+      if (now < prev)
+        fail ("clock went from %lld to %lld ns", prev, now);
+      if (now > prev && now - prev < min_step)
+        min_step = now - prev;
+      prev = now;
+    }
+  msg ("clock never goes backward");
+
+  CHECK (min_step < TICK_NS, "clock resolves less than a timer tick");
+
+  prev = clock_ns ();
+  for (i = 0; i < 1000000; i++)
+    sink += i;
+  CHECK (clock_ns () > prev, "clock advances while busy");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clock-ns) begin
+(clock-ns) clock never goes backward
+(clock-ns) clock resolves less than a timer tick
+(clock-ns) clock advances while busy
+(clock-ns) end
+clock-ns: exit(0)
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Creates a pipe, runs a child process that writes a message
+   into the pipe's write end, which it inherits, and reads the
+   message back.  Then checks that the pipe reports end of file
+   once the child has exited and the parent has closed its own
+   write end, and that writing with no readers left fails. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static const char expected[] = "message from child-pipe";
+  char buf[64], cmd[32];
+  int fds[2];
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  snprintf (cmd, sizeof cmd, "child-pipe %d", fds[1]);
+  CHECK (wait (exec (cmd)) == 0, "wait (exec (\"child-pipe\"))");
+
+  n = read (fds[0], buf, sizeof buf);
+  if (n != (int) strlen (expected) || memcmp (buf, expected, n))
+    fail ("read %d bytes instead of the child's message", n);
+  msg ("read the child's message");
+
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "end of file");
+
+  CHECK (pipe (fds) == 0, "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], "x", 1) == -1, "write with no readers");
+}
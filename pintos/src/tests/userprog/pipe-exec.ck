@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-exec) begin
+(pipe-exec) pipe
+child-pipe: exit(0)
+(pipe-exec) wait (exec ("child-pipe"))
+(pipe-exec) read the child's message
+(pipe-exec) end of file
+(pipe-exec) pipe
+(pipe-exec) write with no readers
+(pipe-exec) end
+pipe-exec: exit(0)
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Closes the read end of a pipe while another thread is blocked
+   reading it.  The read must still finish, with the byte written
+   afterward, and the descriptor must be gone for everyone else. */
+
+#include <pthread.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int fds[2];
+static volatile int reading;
+static int read_cnt;
+static char c;
+
+static void
+reader (void *aux UNUSED)
+{
+  reading = 1;
+  read_cnt = read (fds[0], &c, 1);
+}
+
+void
+test_main (void)
+{
+  tid_t tid;
+  volatile int i;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  tid = pthread_create (reader, NULL);
+  CHECK (tid != TID_ERROR, "start reader");
+
+  /* Spin for long enough that the reader gets scheduled and goes
+     to sleep in read(). */
+  while (!reading)
+    continue;
+  for (i = 0; i < 10000000; i++)
+    continue;
+
+  msg ("close read end");
+  close (fds[0]);
+  CHECK (write (fds[1], "x", 1) == 1, "write");
+  pthread_join (tid);
+  CHECK (read_cnt == 1 && c == 'x', "reader got the byte");
+  CHECK (read (fds[0], &c, 1) == -1, "read closed fd");
+}
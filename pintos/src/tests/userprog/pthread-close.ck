@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pthread-close) begin
+(pthread-close) pipe
+(pthread-close) start reader
+(pthread-close) close read end
+(pthread-close) write
+(pthread-close) reader got the byte
+(pthread-close) read closed fd
+(pthread-close) end
+pthread-close: exit(0)
+EOF
+pass;
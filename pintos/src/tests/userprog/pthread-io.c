@@ -0,0 +1,80 @@
+/* Starts a thread that reads a file through a descriptor opened
+   by the main thread while other threads compute, then joins them
+   all and checks that every thread saw the same memory and file
+   table but ran on a stack of its own. */
+
+#include <pthread.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define WORKER_CNT 3
+
+static int fd;
+static char buf[sizeof sample];
+static int read_cnt;
+
+static tid_t worker_tids[WORKER_CNT];
+static unsigned sums[WORKER_CNT];
+static void *stacks[WORKER_CNT + 1];
+
+static void
+reader (void *aux UNUSED)
+{
+  int local;
+
+  stacks[WORKER_CNT] = &local;
+  read_cnt = read (fd, buf, sizeof buf - 1);
+}
+
+static void
+worker (void *aux)
+{
+  int id = (int) aux;
+  unsigned i;
+
+  stacks[id] = &id;
+  worker_tids[id] = get_tid ();
+  for (i = 1; i <= 100000; i++)
+    sums[id] += i * (id + 1);
+}
+
+void
+test_main (void)
+{
+  tid_t reader_tid, tids[WORKER_CNT];
+  int i, j;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((reader_tid = pthread_create (reader, NULL)) != TID_ERROR,
+         "start reader");
+  for (i = 0; i < WORKER_CNT; i++)
+    if ((tids[i] = pthread_create (worker, (void *) i)) == TID_ERROR)
+      fail ("start worker %d", i);
+  msg ("start workers");
+
+  CHECK (pthread_join (reader_tid), "join reader");
+  for (i = 0; i < WORKER_CNT; i++)
+    if (!pthread_join (tids[i]))
+      fail ("join worker %d", i);
+  msg ("join workers");
+  CHECK (!pthread_join (tids[0]), "join worker 0 again fails");
+
+  if (read_cnt != sizeof sample - 1 || memcmp (buf, sample, read_cnt))
+    fail ("reader read %d bytes, not the %zu bytes of \"sample.txt\"",
+          read_cnt, sizeof sample - 1);
+  for (i = 0; i < WORKER_CNT; i++)
+    {
+      if (worker_tids[i] != tids[i] || tids[i] == get_tid ())
+        fail ("worker %d has tid %d, not %d", i, worker_tids[i], tids[i]);
+      if (sums[i] != 705082704u * (i + 1))
+        fail ("worker %d computed %u", i, sums[i]);
+    }
+  for (i = 0; i <= WORKER_CNT; i++)
+    for (j = 0; j < i; j++)
+      if (stacks[i] == NULL || stacks[i] == stacks[j])
+        fail ("threads %d and %d share a stack", i, j);
+  msg ("threads shared memory and files");
+}
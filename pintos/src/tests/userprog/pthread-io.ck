@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pthread-io) begin
+(pthread-io) open "sample.txt"
+(pthread-io) start reader
+(pthread-io) start workers
+(pthread-io) join reader
+(pthread-io) join workers
+(pthread-io) join worker 0 again fails
+(pthread-io) threads shared memory and files
+(pthread-io) end
+pthread-io: exit(0)
+EOF
+pass;
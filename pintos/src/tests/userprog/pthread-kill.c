@@ -0,0 +1,76 @@
+/* Returns from main while other threads are still busy: one is
+   blocked on a mutex that main holds, one is blocked reading an
+   empty pipe, one is blocked joining the next, and the last spins
+   in user mode without ever making a system call.  The process
+   must still exit, with main's status. */
+
+#include <pthread.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static int fds[2];
+static tid_t spinner_tid;
+static volatile int reading, joining, spinning;
+
+static void
+locker (void *aux UNUSED)
+{
+  pthread_mutex_lock (&mutex);
+  fail ("locked a mutex that main never unlocks");
+}
+
+static void
+reader (void *aux UNUSED)
+{
+  char c;
+
+  reading = 1;
+  read (fds[0], &c, 1);
+  fail ("read from a pipe that nobody writes");
+}
+
+static void
+joiner (void *aux UNUSED)
+{
+  joining = 1;
+  pthread_join (spinner_tid);
+  fail ("joined a thread that never finishes");
+}
+
+static void
+spinner (void *aux UNUSED)
+{
+  for (;;)
+    spinning = 1;
+}
+
+/* Waits, without making system calls, until *P is VALUE. */
+static void
+wait_for (volatile int *p, int value)
+{
+  while (*p != value)
+    continue;
+}
+
+void
+test_main (void)
+{
+  pthread_mutex_lock (&mutex);
+  CHECK (pipe (fds) == 0, "pipe");
+
+  CHECK (pthread_create (locker, NULL) != TID_ERROR, "start locker");
+  CHECK (pthread_create (reader, NULL) != TID_ERROR, "start reader");
+  spinner_tid = pthread_create (spinner, NULL);
+  CHECK (spinner_tid != TID_ERROR, "start spinner");
+  CHECK (pthread_create (joiner, NULL) != TID_ERROR, "start joiner");
+
+  /* The locker marks the mutex contended just before it sleeps
+     on it. */
+  wait_for (&mutex.state, 2);
+  wait_for (&reading, 1);
+  wait_for (&joining, 1);
+  wait_for (&spinning, 1);
+  msg ("all threads busy");
+}
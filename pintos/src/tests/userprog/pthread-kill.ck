@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pthread-kill) begin
+(pthread-kill) pipe
+(pthread-kill) start locker
+(pthread-kill) start reader
+(pthread-kill) start spinner
+(pthread-kill) start joiner
+(pthread-kill) all threads busy
+(pthread-kill) end
+pthread-kill: exit(0)
+EOF
+pass;
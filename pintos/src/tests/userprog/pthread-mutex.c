@@ -0,0 +1,107 @@
+/* Has several threads increment a shared counter under a mutex,
+   long enough for the timer to preempt them while they hold it,
+   then passes items from producer threads to consumer threads
+   through a small buffer guarded by a mutex and two condition
+   variables. */
+
+#include <pthread.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define INCREMENT_CNT 50000
+#define ITEM_CNT 2000
+#define QUEUE_SIZE 4
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int counter;
+
+static pthread_cond_t not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t not_full = PTHREAD_COND_INITIALIZER;
+static int queue[QUEUE_SIZE];
+static int queue_cnt;
+static int consumed_sum;
+
+static void
+incrementer (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < INCREMENT_CNT; i++)
+    {
+      pthread_mutex_lock (&mutex);
+      counter = counter + 1;
+      pthread_mutex_unlock (&mutex);
+    }
+}
+
+static void
+producer (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 1; i <= ITEM_CNT; i++)
+    {
+      pthread_mutex_lock (&mutex);
+      while (queue_cnt == QUEUE_SIZE)
+        pthread_cond_wait (&not_full, &mutex);
+      queue[queue_cnt++] = i;
+      pthread_cond_signal (&not_empty);
+      pthread_mutex_unlock (&mutex);
+    }
+}
+
+static void
+consumer (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ITEM_CNT; i++)
+    {
+      pthread_mutex_lock (&mutex);
+      while (queue_cnt == 0)
+        pthread_cond_wait (&not_empty, &mutex);
+      consumed_sum += queue[--queue_cnt];
+      pthread_cond_signal (&not_full);
+      pthread_mutex_unlock (&mutex);
+    }
+}
+
+/* Starts THREAD_CNT threads, giving the first half FIRST and the
+   rest SECOND, and joins them all. */
+static void
+run_threads (pthread_fun first, pthread_fun second)
+{
+  tid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      tids[i] = pthread_create (i < THREAD_CNT / 2 ? first : second, NULL);
+      if (tids[i] == TID_ERROR)
+        fail ("pthread_create");
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    if (!pthread_join (tids[i]))
+      fail ("pthread_join");
+}
+
+void
+test_main (void)
+{
+  run_threads (incrementer, incrementer);
+  if (counter != THREAD_CNT * INCREMENT_CNT)
+    fail ("counter is %d instead of %d", counter, THREAD_CNT * INCREMENT_CNT);
+  msg ("counter is correct");
+
+  run_threads (producer, consumer);
+  if (queue_cnt != 0
+      || consumed_sum != THREAD_CNT / 2 * (ITEM_CNT * (ITEM_CNT + 1) / 2))
+    fail ("consumers took %d, leaving %d items", consumed_sum, queue_cnt);
+  msg ("every item was consumed once");
+
+  CHECK (pthread_mutex_trylock (&mutex), "trylock unlocked mutex");
+  CHECK (!pthread_mutex_trylock (&mutex), "trylock locked mutex fails");
+  pthread_mutex_unlock (&mutex);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pthread-mutex) begin
+(pthread-mutex) counter is correct
+(pthread-mutex) every item was consumed once
+(pthread-mutex) trylock unlocked mutex
+(pthread-mutex) trylock locked mutex fails
+(pthread-mutex) end
+pthread-mutex: exit(0)
+EOF
+pass;
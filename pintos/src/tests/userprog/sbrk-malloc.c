@@ -0,0 +1,86 @@
+/* Grows and shrinks the heap with sbrk(), then allocates and
+   frees blocks of many sizes with malloc() and free(), checking
+   that no two live blocks overlap. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of blocks live at once. */
+#define SLOT_CNT 64
+
+static char *blocks[SLOT_CNT];
+static size_t sizes[SLOT_CNT];
+
+/* Checks that block I still holds its own index in every byte. */
+static void
+check_block (int i)
+{
+  size_t j;
+
+  for (j = 0; j < sizes[i]; j++)
+    if (blocks[i][j] != (char) i)
+      fail ("byte %zu of %zu-byte block %d was overwritten",
+            j, sizes[i], i);
+}
+
+void
+test_main (void)
+{
+  char *old_break, *p;
+  unsigned seed = 1;
+  int round, i;
+
+  old_break = sbrk (0);
+  CHECK (sbrk (8192) == old_break, "sbrk (8192)");
+  p = old_break;
+  memset (p, 0x5a, 8192);
+  CHECK (sbrk (0) == p + 8192, "break moved by 8192 bytes");
+  CHECK (sbrk (-8192) == p + 8192, "sbrk (-8192)");
+  CHECK (sbrk (0) == old_break, "break restored");
+  CHECK (sbrk (-(intptr_t) 0x10000000) == (void *) -1,
+         "sbrk below the heap fails");
+
+  for (round = 0; round < 2048; round++)
+    {
+      seed = seed * 1103515245 + 12345;
+      i = (seed >> 16) % SLOT_CNT;
+      if (blocks[i] != NULL)
+        {
+          check_block (i);
+          free (blocks[i]);
+        }
+
+      seed = seed * 1103515245 + 12345;
+      sizes[i] = (seed >> 16) % 8 == 0 ? (seed >> 16) % 20000 + 1
+                                       : (seed >> 16) % 300 + 1;
+      blocks[i] = malloc (sizes[i]);
+      if (blocks[i] == NULL)
+        fail ("malloc (%zu) failed", sizes[i]);
+      if ((uintptr_t) blocks[i] % 8 != 0)
+        fail ("malloc (%zu) returned misaligned %p", sizes[i], blocks[i]);
+      memset (blocks[i], i, sizes[i]);
+    }
+  msg ("allocated and freed 2048 blocks");
+
+  for (i = 0; i < SLOT_CNT; i++)
+    {
+      check_block (i);
+      free (blocks[i]);
+    }
+
+  p = calloc (1000, 4);
+  CHECK (p != NULL, "calloc (1000, 4)");
+  for (i = 0; i < 4000; i++)
+    if (p[i] != 0)
+      fail ("calloc'd byte %d is nonzero", i);
+  p = realloc (p, 40000);
+  CHECK (p != NULL, "realloc to 40000 bytes");
+  for (i = 0; i < 4000; i++)
+    if (p[i] != 0)
+      fail ("realloc lost byte %d", i);
+  free (p);
+}
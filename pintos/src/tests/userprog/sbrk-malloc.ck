@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sbrk-malloc) begin
+(sbrk-malloc) sbrk (8192)
+(sbrk-malloc) break moved by 8192 bytes
+(sbrk-malloc) sbrk (-8192)
+(sbrk-malloc) break restored
+(sbrk-malloc) sbrk below the heap fails
+(sbrk-malloc) allocated and freed 2048 blocks
+(sbrk-malloc) calloc (1000, 4)
+(sbrk-malloc) realloc to 40000 bytes
+(sbrk-malloc) end
+sbrk-malloc: exit(0)
+EOF
+pass;
@@ -0,0 +1,50 @@
+/* Writes lines to a file through a buffered stream, one
+   character at a time, then reads them back with fgets() and
+   fgetc() and checks that nothing was lost or reordered. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of lines written. */
+#define LINE_CNT 100
+
+void
+test_main (void)
+{
+  char line[64], expected[64];
+  FILE *s;
+  int fd, i;
+  const char *p;
+
+  CHECK (create ("stream.txt", 0), "create \"stream.txt\"");
+  CHECK ((fd = open ("stream.txt")) > 1, "open \"stream.txt\"");
+  s = fdopen (fd, "w");
+  CHECK (s != NULL, "fdopen for writing");
+  for (i = 0; i < LINE_CNT; i++)
+    {
+      snprintf (line, sizeof line, "line %d of the stream test\n", i);
+      for (p = line; *p != '\0'; p++)
+        if (fputc (*p, s) == EOF)
+          fail ("fputc failed on line %d", i);
+    }
+  CHECK (fclose (s) == 0, "fclose");
+
+  CHECK ((fd = open ("stream.txt")) > 1, "open \"stream.txt\" again");
+  s = fdopen (fd, "r");
+  CHECK (s != NULL, "fdopen for reading");
+  for (i = 0; i < LINE_CNT; i++)
+    {
+      snprintf (expected, sizeof expected, "line %d of the stream test\n", i);
+      if (fgets (line, sizeof line, s) == NULL)
+        fail ("fgets returned null on line %d", i);
+      if (strcmp (line, expected))
+        fail ("line %d reads \"%s\"", i, line);
+    }
+  if (fgetc (s) != EOF || !feof (s))
+    fail ("data past the last line");
+  msg ("read back %d lines", LINE_CNT);
+  fclose (s);
+}
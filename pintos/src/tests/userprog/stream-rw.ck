@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stream-rw) begin
+(stream-rw) create "stream.txt"
+(stream-rw) open "stream.txt"
+(stream-rw) fdopen for writing
+(stream-rw) fclose
+(stream-rw) open "stream.txt" again
+(stream-rw) fdopen for reading
+(stream-rw) read back 100 lines
+(stream-rw) end
+stream-rw: exit(0)
+EOF
+pass;
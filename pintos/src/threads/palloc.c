@@ -2,13 +2,16 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/tsc.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -23,14 +26,52 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, pages are managed by a binary buddy allocator.
+   Free pages are grouped into blocks of 2**ORDER pages whose
+   index within the pool is a multiple of 2**ORDER, and there is
+   one free list per order.  A request for PAGE_CNT pages takes a
+   block of the smallest sufficient order, splitting a larger one
+   if necessary, and gives any pages beyond PAGE_CNT straight
+   back.  Freeing pages merges each block with its "buddy", the
+   other half of the next larger block, for as long as the buddy
+   is also free.  Both take time logarithmic in the pool size.
+
+   The pool is modified with interrupts off rather than under a
+   lock, because thread_schedule_tail() frees the pages of dying
+   threads in the middle of a context switch, where it cannot
+   block.  With "-lock-stats", each pool counts how long it keeps
+   interrupts off, in place of the lock statistics. */
+
+/* Blocks have at most 2**MAX_ORDER pages. */
+#define MAX_ORDER 20
+
+/* Value of a pool's orders[] entry for a page that does not
+   begin a free block. */
+#define NO_ORDER 0xff
 
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
+    struct list free_lists[MAX_ORDER + 1]; /* Free blocks by order. */
+    uint8_t *orders;                    /* Order of the free block
+                                           starting at each page. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    const char *name;                   /* Name, for statistics. */
+
+    /* Interrupts-off statistics, kept with "-lock-stats". */
+    uint64_t intr_off_start;            /* TSC when disabled. */
+    unsigned intr_off_cnt;              /* Times disabled. */
+    uint64_t intr_off_total;            /* Total cycles disabled. */
+    uint64_t intr_off_max;              /* Longest time disabled. */
+  };
+
+/* Header at the start of the first page of a free block. */
+struct free_block
+  {
+    struct list_elem elem;              /* Element in free list. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,6 +80,10 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static enum intr_level pool_enter (struct pool *);
+static void pool_leave (struct pool *, enum intr_level);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -71,15 +116,21 @@ void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  enum intr_level old_level;
   void *pages;
   size_t page_idx;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  old_level = pool_enter (pool);
+  page_idx = buddy_alloc (pool, page_cnt);
+  if (page_idx != BITMAP_ERROR)
+    {
+      ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+      bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+    }
+  pool_leave (pool, old_level);
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -118,6 +169,7 @@ void
 palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
+  enum intr_level old_level;
   size_t page_idx;
 
   ASSERT (pg_ofs (pages) == 0);
@@ -137,8 +189,11 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  old_level = pool_enter (pool);
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  buddy_free (pool, page_idx, page_cnt);
+  pool_leave (pool, old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,15 +203,35 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Prints how long each pool kept interrupts off, if
+   "-lock-stats" was given. */
+void
+palloc_print_stats (void)
+{
+  struct pool *pools[] = {&kernel_pool, &user_pool};
+  size_t i;
+
+  for (i = 0; i < sizeof pools / sizeof *pools; i++)
+    {
+      struct pool *p = pools[i];
+      if (p->intr_off_cnt != 0)
+        printf ("Palloc: %s: interrupts off %u times, %"PRIu64" cycles "
+                "total, %"PRIu64" max\n", p->name, p->intr_off_cnt,
+                p->intr_off_total, p->intr_off_max);
+    }
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
+  /* We'll put the pool's used_map and orders at its base.
+     Calculate the space needed for them and subtract it from
+     the pool's size. */
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t bm_pages = DIV_ROUND_UP (bm_size + page_cnt, PGSIZE);
+  int order;
   if (bm_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
   page_cnt -= bm_pages;
@@ -164,9 +239,45 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
+  for (order = 0; order <= MAX_ORDER; order++)
+    list_init (&p->free_lists[order]);
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->orders = (uint8_t *) base + bm_size;
+  memset (p->orders, NO_ORDER, page_cnt);
   p->base = base + bm_pages * PGSIZE;
+  p->name = name;
+
+  /* Put every page on the free lists. */
+  buddy_free (p, 0, page_cnt);
+}
+
+/* Disables interrupts to update POOL and returns the previous
+   interrupt level, for passing to pool_leave(). */
+static enum intr_level
+pool_enter (struct pool *pool)
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (lock_stats_enabled)
+    pool->intr_off_start = rdtsc ();
+  return old_level;
+}
+
+/* Restores OLD_LEVEL after updating POOL, recording how long
+   interrupts were off. */
+static void
+pool_leave (struct pool *pool, enum intr_level old_level)
+{
+  if (lock_stats_enabled)
+    {
+      uint64_t cycles = rdtsc () - pool->intr_off_start;
+
+      pool->intr_off_cnt++;
+      pool->intr_off_total += cycles;
+      if (cycles > pool->intr_off_max)
+        pool->intr_off_max = cycles;
+    }
+  intr_set_level (old_level);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -180,3 +291,104 @@ page_from_pool (const struct pool *pool, void *page)
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the free block header at page PAGE_IDX in POOL. */
+static struct free_block *
+page_block (const struct pool *pool, size_t page_idx)
+{
+  return (struct free_block *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Adds the free block of 2**ORDER pages starting at PAGE_IDX to
+   POOL's free lists. */
+static void
+push_block (struct pool *pool, size_t page_idx, int order)
+{
+  pool->orders[page_idx] = order;
+  list_push_front (&pool->free_lists[order],
+                   &page_block (pool, page_idx)->elem);
+}
+
+/* Removes the free block starting at PAGE_IDX from POOL's free
+   lists. */
+static void
+remove_block (struct pool *pool, size_t page_idx)
+{
+  list_remove (&page_block (pool, page_idx)->elem);
+  pool->orders[page_idx] = NO_ORDER;
+}
+
+/* Frees the block of 2**ORDER pages starting at PAGE_IDX in
+   POOL, merging it with its buddy for as long as the buddy is
+   free too. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order)
+{
+  size_t page_cnt = bitmap_size (pool->used_map);
+
+  for (; order < MAX_ORDER; order++)
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+      if (buddy_idx + ((size_t) 1 << order) > page_cnt
+          || pool->orders[buddy_idx] != order)
+        break;
+      remove_block (pool, buddy_idx);
+      page_idx &= ~((size_t) 1 << order);
+    }
+  push_block (pool, page_idx, order);
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX in POOL to the
+   free lists, as the largest aligned blocks that they divide
+   into. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  while (page_cnt > 0)
+    {
+      int order = page_idx != 0 ? __builtin_ctz (page_idx) : MAX_ORDER;
+      if (order > MAX_ORDER)
+        order = MAX_ORDER;
+      while (((size_t) 1 << order) > page_cnt)
+        order--;
+
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Takes PAGE_CNT contiguous pages from POOL's free lists and
+   returns the index of the first, or BITMAP_ERROR if no block is
+   large enough. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt)
+{
+  size_t page_idx;
+  int order, want;
+
+  /* Find the smallest nonempty free list that will do. */
+  for (want = 0; ((size_t) 1 << want) < page_cnt; want++)
+    if (want == MAX_ORDER)
+      return BITMAP_ERROR;
+  for (order = want; order <= MAX_ORDER; order++)
+    if (!list_empty (&pool->free_lists[order]))
+      break;
+  if (order > MAX_ORDER)
+    return BITMAP_ERROR;
+
+  page_idx = pg_no (list_front (&pool->free_lists[order])) - pg_no (pool->base);
+  ASSERT (pool->orders[page_idx] == order);
+  remove_block (pool, page_idx);
+
+  /* Split off upper halves until the block is the right size,
+     then give back the pages beyond PAGE_CNT. */
+  while (order > want)
+    {
+      order--;
+      push_block (pool, page_idx + ((size_t) 1 << order), order);
+    }
+  buddy_free (pool, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+
+  return page_idx;
+}
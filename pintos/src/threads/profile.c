@@ -0,0 +1,141 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Sampling profiler.
+
+   At every timer interrupt, profile_sample() records where the
+   interrupted code was running: its eip and, for user code, the
+   name of the running program, since each program has its own
+   address space.  Samples are counted in a hash table keyed by
+   eip and program, and profile_print() dumps the counts at
+   shutdown, one line per distinct eip, for utils/pintos-prof to
+   symbolize with the kernel's or the program's binary.
+
+   Samples are taken with interrupts off, so no lock is needed.
+   When the table fills up, further samples at new eips are
+   counted as dropped. */
+
+/* If true, take samples.
+   Controlled by kernel command-line option "-profile". */
+bool profile_enabled;
+
+/* A distinct sampled eip. */
+struct profile_entry {
+    uintptr_t eip;  /* Sampled eip, or 0 if the entry is unused. */
+    uint16_t prog;  /* 0 for the kernel, else 1 + index in progs. */
+    uint32_t count; /* Number of samples. */
+};
+
+#define TABLE_PAGES 24 /* Pages of entries. */
+#define TABLE_SIZE (TABLE_PAGES * PGSIZE / sizeof(struct profile_entry))
+#define TABLE_LIMIT (TABLE_SIZE * 3 / 4) /* Most entries to use. */
+
+/* Names of the user programs seen. */
+#define PROG_MAX 64
+static char progs[PROG_MAX][16];
+static unsigned prog_cnt;
+
+static struct profile_entry *table;
+static unsigned entry_cnt;      /* Entries in use. */
+static unsigned kernel_samples; /* Samples of kernel code. */
+static unsigned user_samples;   /* Samples of user code. */
+static unsigned dropped;        /* Samples that did not fit. */
+
+static int find_prog(const char *name);
+
+/* Allocates the sample table, if profiling is enabled. */
+void profile_init(void) {
+    if (!profile_enabled) return;
+
+    table = palloc_get_multiple(PAL_ZERO, TABLE_PAGES);
+    if (table == NULL) {
+        printf("profile: not enough memory, profiling disabled\n");
+        profile_enabled = false;
+    }
+}
+
+/* Records a sample of the code that the interrupt described by
+   F interrupted.  Must be called with interrupts off. */
+void profile_sample(const struct intr_frame *f) {
+    uintptr_t eip = (uintptr_t)f->eip;
+    bool user = (f->cs & 3) != 0;
+    int prog = 0;
+    unsigned i;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    if (table == NULL) return;
+
+    if (user) {
+        prog = find_prog(thread_current()->name);
+        if (prog < 0) {
+            dropped++;
+            return;
+        }
+        user_samples++;
+    } else
+        kernel_samples++;
+
+    for (i = (eip * 2654435761u + prog) % TABLE_SIZE;; i = (i + 1) % TABLE_SIZE) {
+        struct profile_entry *e = &table[i];
+        if (e->eip == eip && e->prog == prog) {
+            e->count++;
+            return;
+        }
+        if (e->eip == 0) break;
+    }
+
+    if (entry_cnt >= TABLE_LIMIT) {
+        dropped++;
+        return;
+    }
+    table[i].eip = eip;
+    table[i].prog = prog;
+    table[i].count = 1;
+    entry_cnt++;
+}
+
+/* Prints the sample counts, if profiling is enabled. */
+void profile_print(void) {
+    enum intr_level old_level;
+    unsigned i;
+
+    if (table == NULL) return;
+
+    /* Stop sampling, so that the table holds still while we
+       print it. */
+    old_level = intr_disable();
+    profile_enabled = false;
+    intr_set_level(old_level);
+
+    printf("Profile: %u kernel samples, %u user samples, %u dropped\n", kernel_samples,
+           user_samples, dropped);
+    for (i = 0; i < TABLE_SIZE; i++) {
+        const struct profile_entry *e = &table[i];
+        if (e->eip == 0)
+            continue;
+        else if (e->prog == 0)
+            printf("Profile: kernel 0x%08" PRIxPTR " %" PRIu32 "\n", e->eip, e->count);
+        else
+            printf("Profile: user %s 0x%08" PRIxPTR " %" PRIu32 "\n", progs[e->prog - 1], e->eip,
+                   e->count);
+    }
+}
+
+/* Returns 1 plus the index of NAME in progs, adding it if it is
+   not there yet, or -1 if progs is full. */
+static int find_prog(const char *name) {
+    unsigned i;
+
+    for (i = 0; i < prog_cnt; i++)
+        if (!strcmp(progs[i], name)) return i + 1;
+    if (prog_cnt == PROG_MAX) return -1;
+    strlcpy(progs[prog_cnt], name, sizeof progs[prog_cnt]);
+    return ++prog_cnt;
+}
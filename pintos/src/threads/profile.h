@@ -0,0 +1,15 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+/* Sampling profiler.  Enabled by kernel command-line option
+   "-profile". */
+extern bool profile_enabled;
+
+void profile_init(void);
+void profile_sample(const struct intr_frame *);
+void profile_print(void);
+
+#endif /* threads/profile.h */
@@ -0,0 +1,281 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* An object cache ("slab allocator").
+
+   malloc() rounds every request up to a power of 2, which wastes
+   up to half of each block for objects whose size is just above
+   a power of 2.  A cache instead hands out objects of exactly
+   one size, packed into pages called "slabs".  Each slab begins
+   with a header and keeps its own list of free objects.
+
+   A cache tracks its partially full slabs, and allocates from
+   them first so that objects stay packed into as few pages as
+   possible.  Full slabs are not tracked at all: a slab is found
+   again from one of its objects when that object is freed.
+   When a slab becomes empty it is kept as the cache's spare if
+   the cache has none, and otherwise returned to the page
+   allocator.
+
+   If the cache has a constructor, each object is constructed
+   once when its slab is created, and objects come back from
+   kmem_cache_free() still constructed.  So that the link in a
+   free object does not clobber constructed state, such caches
+   keep the link in a word just past the end of each object. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x5ab1ab1e
+
+/* Object cache. */
+struct kmem_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Size requested at creation. */
+    size_t link_ofs;            /* Offset of free link in an object. */
+    size_t stride;              /* Bytes from one object to the next. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    kmem_ctor *ctor;            /* Constructor, or null. */
+    struct lock lock;           /* Protects everything below. */
+    struct list partial;        /* Slabs with some objects free. */
+    struct slab *spare;         /* An empty slab, or null. */
+    size_t slab_cnt;            /* Slabs allocated, including spare. */
+    size_t in_use;              /* Objects allocated. */
+    size_t peak_in_use;         /* Largest value of in_use. */
+    struct list_elem elem;      /* Element in cache_list. */
+  };
+
+/* Slab header, at the start of each slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in cache's partial list. */
+    size_t in_use;              /* Allocated objects in this slab. */
+    void *free;                 /* First free object, or null. */
+  };
+
+/* All caches, for kmem_print_stats(). */
+static struct list cache_list = LIST_INITIALIZER (cache_list);
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+
+/* Returns the free-list link stored in free object OBJ of
+   cache C. */
+static inline void **
+obj_link (struct kmem_cache *c, void *obj)
+{
+  return (void **) ((uint8_t *) obj + c->link_ofs);
+}
+
+/* Creates and returns a cache of SIZE-byte objects named NAME,
+   constructing each object with CTOR if it is nonnull.  NAME
+   must remain valid for as long as the cache exists.  Returns a
+   null pointer if memory is not available. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor *ctor)
+{
+  struct kmem_cache *c;
+  enum intr_level old_level;
+
+  ASSERT (name != NULL);
+  ASSERT (size > 0);
+
+  c = malloc (sizeof *c);
+  if (c == NULL)
+    return NULL;
+
+  c->name = name;
+  c->obj_size = size;
+  c->link_ofs = ctor != NULL ? ROUND_UP (size, sizeof (void *)) : 0;
+  c->stride = ROUND_UP (c->link_ofs + (ctor != NULL ? sizeof (void *) : size),
+                        sizeof (void *));
+  c->objs_per_slab = (PGSIZE - sizeof (struct slab)) / c->stride;
+  ASSERT (c->objs_per_slab > 0);
+  c->ctor = ctor;
+  lock_init_named (&c->lock, c->name);
+  list_init (&c->partial);
+  c->spare = NULL;
+  c->slab_cnt = 0;
+  c->in_use = 0;
+  c->peak_in_use = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&cache_list, &c->elem);
+  intr_set_level (old_level);
+
+  return c;
+}
+
+/* Obtains and returns a new object from cache C.  Returns a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  struct slab *s;
+  void *obj;
+
+  ASSERT (c != NULL);
+
+  lock_acquire (&c->lock);
+
+  /* Prefer a partially full slab, then the spare, and only then
+     a brand new slab. */
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else
+    {
+      if (c->spare != NULL)
+        {
+          s = c->spare;
+          c->spare = NULL;
+        }
+      else
+        {
+          s = slab_create (c);
+          if (s == NULL)
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  /* Take its first free object. */
+  obj = s->free;
+  s->free = *obj_link (c, obj);
+  if (++s->in_use == c->objs_per_slab)
+    list_remove (&s->elem);
+
+  if (++c->in_use > c->peak_in_use)
+    c->peak_in_use = c->in_use;
+  lock_release (&c->lock);
+
+  return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   the cache.  If C has a constructor, OBJ must be in its
+   constructed state. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj)
+{
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (c, obj);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs. */
+  if (c->ctor == NULL)
+    memset (obj, 0xcc, c->obj_size);
+#endif
+
+  lock_acquire (&c->lock);
+
+  *obj_link (c, obj) = s->free;
+  s->free = obj;
+  c->in_use--;
+
+  /* A full slab becomes partial again, and a partial slab may
+     become empty. */
+  if (s->in_use-- == c->objs_per_slab)
+    list_push_front (&c->partial, &s->elem);
+  if (s->in_use == 0)
+    {
+      list_remove (&s->elem);
+      if (c->spare == NULL)
+        c->spare = s;
+      else
+        {
+          c->slab_cnt--;
+          palloc_free_page (s);
+        }
+    }
+
+  lock_release (&c->lock);
+}
+
+/* Prints the object size and page usage of every cache. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&cache_list); e != list_end (&cache_list);
+       e = list_next (e))
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+      printf ("Slab: %s: %zu-byte objects, %zu in use (peak %zu), "
+              "%zu pages\n",
+              c->name, c->obj_size, c->in_use, c->peak_in_use, c->slab_cnt);
+    }
+}
+
+/* Allocates a new slab for cache C, constructs its objects, and
+   threads them all onto the slab's free list.  Returns a null
+   pointer if no page is available.  C's lock must be held. */
+static struct slab *
+slab_create (struct kmem_cache *c)
+{
+  struct slab *s;
+  uint8_t *obj;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&c->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->in_use = 0;
+  s->free = NULL;
+
+  /* Push objects from last to first, so that they are handed
+     out in address order. */
+  obj = (uint8_t *) (s + 1) + c->objs_per_slab * c->stride;
+  for (i = 0; i < c->objs_per_slab; i++)
+    {
+      obj -= c->stride;
+      if (c->ctor != NULL)
+        c->ctor (obj);
+      *obj_link (c, obj) = s->free;
+      s->free = obj;
+    }
+
+  c->slab_cnt++;
+  return s;
+}
+
+/* Returns the slab that contains OBJ, checking that it belongs
+   to cache C. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  /* Check that the slab is valid. */
+  ASSERT (s != NULL);
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+
+  /* Check that the object is properly aligned for the slab. */
+  ASSERT ((pg_ofs (obj) - sizeof *s) % c->stride == 0);
+
+  return s;
+}
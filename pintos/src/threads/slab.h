@@ -0,0 +1,20 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches for fixed-size kernel objects. */
+struct kmem_cache;
+
+/* Constructs the object at OBJ.  Run once for each object when
+   its slab is created; objects must be freed in their
+   constructed state. */
+typedef void kmem_ctor (void *obj);
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+                                      kmem_ctor *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -27,10 +27,36 @@
 */
 
 #include "threads/synch.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/tsc.h"
+
+/* Lock contention statistics.  Only locks initialized with
+   lock_init_named() while lock_stats_enabled is true get a
+   slot; all times are in TSC cycles. */
+struct lock_stats {
+    char name[16];            /* Lock name. */
+    unsigned acquisitions;    /* Times acquired. */
+    unsigned contended;       /* Times that had to wait. */
+    uint64_t total_wait;      /* Cycles spent waiting, in total. */
+    uint64_t max_wait;        /* Longest wait. */
+    uint64_t max_hold;        /* Longest time held. */
+    uint64_t acquired_at;     /* When the current holder got it. */
+    int max_chain;            /* Longest priority donation chain. */
+    unsigned wait_hist[32];   /* Waits by floor(log2(cycles)). */
+};
+
+#define LOCK_STATS_MAX 32
+static struct lock_stats lock_stats[LOCK_STATS_MAX];
+static unsigned lock_stats_cnt;
+
+bool lock_stats_enabled;
+
+static void record_acquire(struct lock *, bool contended, uint64_t wait, int chain);
 
 /* Returns true if priority of A is less than priority of B, false
    otherwise. */
@@ -104,6 +130,56 @@ void sema_down(struct semaphore *sema) {
     intr_set_level(old_level);
 }
 
+/* Like sema_down(), but gives up without decrementing SEMA if
+   sema_interrupt() is called on the running thread before or
+   while it waits.  Returns true if SEMA was decremented, false
+   if the wait was interrupted. */
+bool sema_down_interruptible(struct semaphore *sema) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+    bool success = true;
+
+    ASSERT(sema != NULL);
+    ASSERT(!intr_context());
+
+    old_level = intr_disable();
+    while (sema->value == 0) {
+        if (cur->interrupted) {
+            success = false;
+            break;
+        }
+        list_push_back(&sema->waiters, &cur->elem);
+        cur->interruptible = true;
+        thread_block();
+        cur->interruptible = false;
+    }
+    if (success) sema->value--;
+    intr_set_level(old_level);
+
+    return success;
+}
+
+/* Interrupts thread T's interruptible waits: wakes T if it is
+   blocked in sema_down_interruptible(), and makes every such
+   wait that T starts from now on fail at once.  Used to get the
+   threads of an exiting process out of the kernel.
+
+   This function may be called from an interrupt handler. */
+void sema_interrupt(struct thread *t) {
+    enum intr_level old_level;
+
+    ASSERT(t != NULL);
+
+    old_level = intr_disable();
+    t->interrupted = true;
+    if (t->status == THREAD_BLOCKED && t->interruptible) {
+        list_remove(&t->elem);
+        t->interruptible = false;
+        thread_unblock(t);
+    }
+    intr_set_level(old_level);
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
@@ -201,10 +277,24 @@ static void sema_test_helper(void *sema_) {
 void lock_init(struct lock *lock) {
     ASSERT(lock != NULL);
     lock->holder = NULL;
+    lock->stats = NULL;
 
     sema_init(&lock->semaphore, 1);
 }
 
+/* Initializes LOCK like lock_init() and, if lock statistics are
+   enabled, gives it a statistics slot under NAME, which is
+   copied.  Once every slot is taken, further locks go
+   unmeasured. */
+void lock_init_named(struct lock *lock, const char *name) {
+    lock_init(lock);
+    if (lock_stats_enabled && lock_stats_cnt < LOCK_STATS_MAX) {
+        struct lock_stats *s = &lock_stats[lock_stats_cnt++];
+        strlcpy(s->name, name, sizeof s->name);
+        lock->stats = s;
+    }
+}
+
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
@@ -224,33 +314,43 @@ void lock_acquire(struct lock *lock) {
 
     // Start by seeing if lock is available
     bool success = sema_try_down(&lock->semaphore);
+    uint64_t wait = 0;
+    int chain = 0;
 
     // If not successfull, start donating priotity
     if (!success) {
         struct thread *curr_thread = thread_current();
         struct thread *lock_holder = lock->holder;
+        uint64_t start = lock->stats != NULL ? rdtsc() : 0;
 
         curr_thread->needs_lock = lock;
+        TRACE(LOCK_WAIT, lock, lock_holder->tid, 0);
 
         // Priority donation chaining
-        chain_priority(curr_thread, lock_holder);
+        chain = chain_priority(curr_thread, lock_holder);
 
         sema_down(&lock->semaphore);
         curr_thread->needs_lock = NULL;
+        TRACE(LOCK_ACQUIRE, lock, 0, 0);
+        if (lock->stats != NULL) wait = rdtsc() - start;
     }
 
     lock->holder = thread_current();
     list_push_back(&thread_current()->held_locks, &lock->held_lock_elem);
+    if (lock->stats != NULL) record_acquire(lock, !success, wait, chain);
     intr_set_level(old_level);
 }
 
 /* Pre condition: Lock-holder exisits
     Iteratively donates current thread's priotity to thead currently holding
-   lock.
+   lock.  Returns the number of threads that received a donation.
 */
-void chain_priority(struct thread *curr_thread, struct thread *lock_holder) {
+int chain_priority(struct thread *curr_thread, struct thread *lock_holder) {
+    int depth = 0;
+
     while (curr_thread->priority > lock_holder->priority) {
-        lock_holder->priority = curr_thread->priority;
+        thread_donate_priority(curr_thread, lock_holder);
+        depth++;
 
         if (lock_holder->needs_lock == NULL) {
             break;
@@ -258,6 +358,26 @@ void chain_priority(struct thread *curr_thread, struct thread *lock_holder) {
         curr_thread = lock_holder;
         lock_holder = lock_holder->needs_lock->holder;
     }
+    return depth;
+}
+
+/* Records an acquisition of LOCK, which has statistics.  If
+   CONTENDED, the caller waited WAIT cycles for it and donated
+   priority along a chain of CHAIN threads.  Interrupts must be
+   off. */
+static void record_acquire(struct lock *lock, bool contended, uint64_t wait, int chain) {
+    struct lock_stats *s = lock->stats;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    s->acquisitions++;
+    if (contended) {
+        s->contended++;
+        s->total_wait += wait;
+        if (wait > s->max_wait) s->max_wait = wait;
+        s->wait_hist[wait >> 32 ? 31 : 31 - __builtin_clz((uint32_t)wait | 1)]++;
+    }
+    if (chain > s->max_chain) s->max_chain = chain;
+    s->acquired_at = rdtsc();
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -276,6 +396,11 @@ bool lock_try_acquire(struct lock *lock) {
     if (success) {
         lock->holder = thread_current();
         list_push_back(&thread_current()->held_locks, &lock->held_lock_elem);
+        if (lock->stats != NULL) {
+            enum intr_level old_level = intr_disable();
+            record_acquire(lock, false, 0, 0);
+            intr_set_level(old_level);
+        }
     }
     return success;
 }
@@ -291,6 +416,10 @@ void lock_release(struct lock *lock) {
     ASSERT(lock != NULL);
     ASSERT(lock_held_by_current_thread(lock));
     enum intr_level old_level = intr_disable();
+    if (lock->stats != NULL) {
+        uint64_t hold = rdtsc() - lock->stats->acquired_at;
+        if (hold > lock->stats->max_hold) lock->stats->max_hold = hold;
+    }
     list_remove(&lock->held_lock_elem);
 
     if (list_empty(&thread_current()->held_locks)) {
@@ -332,6 +461,26 @@ bool lock_held_by_current_thread(const struct lock *lock) {
     return lock->holder == thread_current();
 }
 
+/* Prints the statistics of each named lock that was acquired at
+   least once. */
+void lock_print_stats(void) {
+    unsigned i, j;
+
+    for (i = 0; i < lock_stats_cnt; i++) {
+        struct lock_stats *s = &lock_stats[i];
+        if (s->acquisitions == 0) continue;
+
+        printf("Lock: %s: %u acquisitions, %u contended, wait %llu cycles total, "
+               "%llu max, hold %llu max, donation chain %d\n",
+               s->name, s->acquisitions, s->contended, s->total_wait, s->max_wait,
+               s->max_hold, s->max_chain);
+        for (j = 0; j < 32; j++)
+            if (s->wait_hist[j] != 0)
+                printf("Lock: %s: waited [2^%u, 2^%u) cycles %u times\n", s->name, j, j + 1,
+                       s->wait_hist[j]);
+    }
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem {
     struct list_elem elem;      /* List element. */
@@ -407,6 +556,36 @@ void cond_wait(struct condition *cond, struct lock *lock) {
     lock_acquire(lock);
 }
 
+/* Like cond_wait(), but returns false if the wait was
+   interrupted by sema_interrupt() before COND was signaled, true
+   otherwise.  LOCK is reacquired either way. */
+bool cond_wait_interruptible(struct condition *cond, struct lock *lock) {
+    struct semaphore_elem waiter;
+    bool signaled;
+
+    ASSERT(cond != NULL);
+    ASSERT(lock != NULL);
+    ASSERT(!intr_context());
+    ASSERT(lock_held_by_current_thread(lock));
+
+    sema_init(&waiter.semaphore, 0);
+    list_push_back(&cond->waiters, &waiter.elem);
+    lock_release(lock);
+    signaled = sema_down_interruptible(&waiter.semaphore);
+    lock_acquire(lock);
+
+    /* COND is only signaled with LOCK held, so by now either a
+       signal has taken us off COND's list and upped our
+       semaphore, or none will. */
+    if (!signaled) {
+        if (sema_try_down(&waiter.semaphore))
+            signaled = true;
+        else
+            list_remove(&waiter.elem);
+    }
+    return signaled;
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -4,6 +4,8 @@
 #include <list.h>
 #include <stdbool.h>
 
+struct thread;
+
 /* A counting semaphore. */
 struct semaphore {
     unsigned value;      /* Current value. */
@@ -12,6 +14,8 @@ struct semaphore {
 
 void sema_init(struct semaphore *, unsigned value);
 void sema_down(struct semaphore *);
+bool sema_down_interruptible(struct semaphore *);
+void sema_interrupt(struct thread *);
 bool sema_try_down(struct semaphore *);
 void sema_up(struct semaphore *);
 void sema_self_test(void);
@@ -22,14 +26,22 @@ struct lock {
     struct semaphore semaphore; /* Binary semaphore controlling access. */
     struct list_elem
         held_lock_elem; /* List element for thread held_lock lists */
+    struct lock_stats *stats;   /* Contention statistics, or null. */
 };
 
+/* If true, locks initialized with lock_init_named() keep
+   contention statistics.  Controlled by kernel command-line
+   option "-lock-stats". */
+extern bool lock_stats_enabled;
+
 void lock_init(struct lock *);
+void lock_init_named(struct lock *, const char *name);
+void lock_print_stats(void);
 void lock_acquire(struct lock *);
 bool lock_try_acquire(struct lock *);
 void lock_release(struct lock *);
 bool lock_held_by_current_thread(const struct lock *);
-void chain_priority(struct thread *curr_thread, struct thread *lock_holder);
+int chain_priority(struct thread *curr_thread, struct thread *lock_holder);
 
 /* Condition variable. */
 struct condition {
@@ -38,6 +50,7 @@ struct condition {
 
 void cond_init(struct condition *);
 void cond_wait(struct condition *, struct lock *);
+bool cond_wait_interruptible(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
 
@@ -9,10 +9,12 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
-#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
+#include "threads/tsc.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 
@@ -21,9 +23,16 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO
+   queue per priority level, and bit P of ready_mask is set
+   whenever ready_queues[P] is nonempty, so that enqueueing and
+   picking the next thread are both constant time. */
+#define READY_MASK_BITS 32
+#define READY_MASK_CNT ((PRI_MAX - PRI_MIN + READY_MASK_BITS) / READY_MASK_BITS)
+static struct list ready_queues[PRI_MAX - PRI_MIN + 1];
+static uint32_t ready_mask[READY_MASK_CNT];
+static size_t ready_cnt; /* Number of threads on ready_queues. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -35,6 +44,9 @@ static struct thread *idle_thread;
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
+/* Cache of babysitters, one per thread. */
+static struct kmem_cache *babysitter_cache;
+
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
@@ -50,6 +62,11 @@ static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
 
+/* Histogram of TSC cycles spent in thread_tick(), bucketed by
+   floor(log2(cycles)). */
+#define TICK_HIST_BUCKETS 32
+static unsigned tick_cycle_hist[TICK_HIST_BUCKETS];
+
 /* Scheduling. */
 #define TIME_SLICE 4          /* # of timer ticks to give each thread. */
 static unsigned thread_ticks; /* # of timer ticks since last yield. */
@@ -61,12 +78,28 @@ bool thread_mlfqs;
 
 /* Load Average calculated every second */
 fixed_point_t load_average;
+
+/* Once a second every thread's recent_cpu decays by a coefficient
+   derived from load_average.  Rather than walking every thread in
+   the timer interrupt, the coefficient for each second ("epoch")
+   is recorded here and a thread catches up on the decays it
+   missed the next time it is examined (see update_recent_cpu()):
+   a blocked thread when it is unblocked, a ready thread when it
+   reaches the front of the highest ready queue.  Decays older
+   than the last DECAY_HISTORY are applied all at once using the
+   oldest recorded coefficient. */
+#define DECAY_HISTORY 64
+static fixed_point_t decay_coeffs[DECAY_HISTORY];
+static unsigned decay_epoch;
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
-static struct thread *running_thread(void);
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
+static void ready_queue_push(struct thread *);
+static void ready_queue_remove(struct thread *);
+static int mlfqs_priority(struct thread *);
+static void mlfqs_decay(struct thread *);
 static bool is_thread(struct thread *) UNUSED;
 static void *alloc_frame(struct thread *, size_t size);
 static void schedule(void);
@@ -87,10 +120,12 @@ static tid_t allocate_tid(void);
    It is not safe to call thread_current() until this function
    finishes. */
 void thread_init(void) {
+    int i;
+
     ASSERT(intr_get_level() == INTR_OFF);
 
     lock_init(&tid_lock);
-    list_init(&ready_list);
+    for (i = PRI_MIN; i <= PRI_MAX; i++) list_init(&ready_queues[i - PRI_MIN]);
     list_init(&all_list);
     load_average = fix_int(0);
 
@@ -107,6 +142,9 @@ void thread_init(void) {
 /* Starts preemptive thread scheduling by enabling interrupts.
    Also creates the idle thread. */
 void thread_start(void) {
+    babysitter_cache = kmem_cache_create("babysitter", sizeof(struct babysitter), NULL);
+    if (babysitter_cache == NULL) PANIC("babysitter cache creation failed");
+
     /* Create the idle thread. */
     struct semaphore idle_started;
     sema_init(&idle_started, 0);
@@ -123,8 +161,11 @@ void thread_start(void) {
    Thus, this function runs in an external interrupt context. */
 void thread_tick(void) {
     struct thread *t = thread_current();
+    uint64_t start = rdtsc();
+    uint64_t cycles;
 
     /* Update statistics. */
+    t->run_ticks++;
     if (t == idle_thread) idle_ticks++;
 #ifdef USERPROG
     else if (t->pagedir != NULL)
@@ -136,17 +177,50 @@ void thread_tick(void) {
     /* Enforce preemption. */
     if (++thread_ticks >= TIME_SLICE) intr_yield_on_return();
 
-    /* Write mlfq code here (the algorithm in the notion document) */
+    /* Only the running thread's recent_cpu grows from tick to
+       tick, so between once-a-second decays it is the only thread
+       whose priority can change.  Other threads catch up on a
+       decay when they are next examined. */
     if (thread_mlfqs) {
-        running_thread()->recent_cpu = fix_add(running_thread()->recent_cpu, fix_int(1));
-        if (timer_ticks() % TIMER_FREQ == 0) {
-            update_load_average();
-            thread_foreach(update_recent_cpu, 0);
-        }
+        t->recent_cpu = fix_add(t->recent_cpu, fix_int(1));
+        if (timer_ticks() % TIMER_FREQ == 0) mlfqs_decay(t);
         if (timer_ticks() % 4 == 0) {
-            thread_foreach(update_priorities, 0);
+            update_priorities(t, NULL);
         }
     }
+
+    cycles = rdtsc() - start;
+    if (cycles >> 32)
+        tick_cycle_hist[TICK_HIST_BUCKETS - 1]++;
+    else
+        tick_cycle_hist[31 - __builtin_clz((uint32_t)cycles | 1)]++;
+}
+
+/* Accounts for a timer tick that elapsed while the idle thread
+   was halted with the periodic timer stopped (see
+   timer_idle_enter()).  Unlike thread_tick(), this may be called
+   outside of interrupt context, and it never requests a yield. */
+void thread_idle_tick(void) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    idle_ticks++;
+    idle_thread->run_ticks++;
+    if (thread_mlfqs && timer_ticks() % TIMER_FREQ == 0) mlfqs_decay(idle_thread);
+}
+
+/* Once-a-second mlfqs work: updates the load average, records
+   this second's recent_cpu decay, and applies it to the running
+   thread T. */
+static void mlfqs_decay(struct thread *t) {
+    fixed_point_t twice_load;
+
+    update_load_average();
+    twice_load = fix_scale(load_average, 2);
+    decay_coeffs[decay_epoch % DECAY_HISTORY] =
+        fix_div(twice_load, fix_add(twice_load, fix_int(1)));
+    decay_epoch++;
+
+    update_recent_cpu(t, NULL);
 }
 
 /* Updates global load average */
@@ -155,8 +229,7 @@ void update_load_average(void) {
 
     fixed_point_t a1 = fix_mul(fix_int(59), load_average);
     fixed_point_t a2 = fix_div(a1, fix_int(60));
-    int ready_list_size =
-        thread_current() == idle_thread ? (list_size(&ready_list)) : (list_size(&ready_list)) + 1;
+    int ready_list_size = thread_current() == idle_thread ? ready_cnt : ready_cnt + 1;
     fixed_point_t ready_list_float_size = fix_int(ready_list_size);
     fixed_point_t b2 = fix_div(ready_list_float_size, fix_int(60));
     load_average = fix_add(a2, b2);
@@ -164,8 +237,70 @@ void update_load_average(void) {
 
 /* Prints thread statistics. */
 void thread_print_stats(void) {
+    int i;
+
     printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks,
            kernel_ticks, user_ticks);
+
+    printf("Thread tick cycles:");
+    for (i = 0; i < TICK_HIST_BUCKETS; i++)
+        if (tick_cycle_hist[i] != 0) printf(" [2^%d] %u", i, tick_cycle_hist[i]);
+    printf("\n");
+
+    thread_print_accounting();
+}
+
+/* Copy of one thread's accounting, taken so that it can be
+   printed with interrupts on. */
+struct thread_accounting {
+    tid_t tid;
+    char name[16];
+    unsigned run_ticks;
+    unsigned sched_cnt;
+    unsigned voluntary_switches;
+    unsigned preempted_switches;
+    unsigned syscall_cnt;
+    uint64_t lock_wait_cycles;
+    uint64_t ready_wait_cycles;
+};
+
+/* Prints the scheduler accounting of every live thread. */
+void thread_print_accounting(void) {
+    struct thread_accounting *snap;
+    size_t cnt = 0, max = PGSIZE / sizeof *snap;
+    enum intr_level old_level;
+    struct list_elem *e;
+    size_t i;
+
+    /* Threads may come and go while we print, so take a copy. */
+    snap = palloc_get_page(0);
+    if (snap == NULL) return;
+    old_level = intr_disable();
+    for (e = list_begin(&all_list); e != list_end(&all_list) && cnt < max; e = list_next(e)) {
+        struct thread *t = list_entry(e, struct thread, allelem);
+        struct thread_accounting *a = &snap[cnt++];
+
+        a->tid = t->tid;
+        strlcpy(a->name, t->name, sizeof a->name);
+        a->run_ticks = t->run_ticks;
+        a->sched_cnt = t->sched_cnt;
+        a->voluntary_switches = t->voluntary_switches;
+        a->preempted_switches = t->preempted_switches;
+        a->syscall_cnt = t->syscall_cnt;
+        a->lock_wait_cycles = t->lock_wait_cycles;
+        a->ready_wait_cycles = t->ready_wait_cycles;
+    }
+    intr_set_level(old_level);
+
+    printf("Thread accounting (tid name: ticks, scheduled, voluntary, preempted, "
+           "syscalls, lock wait cycles, ready wait cycles):\n");
+    for (i = 0; i < cnt; i++) {
+        struct thread_accounting *a = &snap[i];
+        printf("  %d %s: %u, %u, %u, %u, %u, %llu, %llu\n", a->tid, a->name, a->run_ticks,
+               a->sched_cnt, a->voluntary_switches, a->preempted_switches, a->syscall_cnt,
+               a->lock_wait_cycles, a->ready_wait_cycles);
+    }
+    palloc_free_page(snap);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -201,10 +336,12 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
     tid = t->tid = allocate_tid();
 
     /* Initialize process info struct */
-    struct babysitter *b = malloc(sizeof(struct babysitter));
+    struct babysitter *b = kmem_cache_alloc(babysitter_cache);
     sema_init(&b->sema_loading, 0);
     list_push_front(&running_thread()->children, &b->child_elem);
     b->tid = t->tid;
+    b->parent_tid = running_thread()->leader != NULL ? running_thread()->leader->tid
+                                                     : running_thread()->tid;
     b->load_success = false;
     b->exit_code = -1;
     b->file = NULL;
@@ -244,10 +381,14 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
    is usually a better idea to use one of the synchronization
    primitives in synch.h. */
 void thread_block(void) {
+    struct thread *cur = thread_current();
+
     ASSERT(!intr_context());
     ASSERT(intr_get_level() == INTR_OFF);
 
-    thread_current()->status = THREAD_BLOCKED;
+    TRACE(THREAD_BLOCK, cur->needs_lock != NULL ? cur->needs_lock->holder->tid : 0,
+          cur->priority, 0);
+    cur->status = THREAD_BLOCKED;
     schedule();
 }
 
@@ -261,16 +402,28 @@ void thread_block(void) {
    update other data. */
 void thread_unblock(struct thread *t) {
     enum intr_level old_level;
+    uint64_t now;
 
     ASSERT(is_thread(t));
 
     old_level = intr_disable();
     ASSERT(t->status == THREAD_BLOCKED);
-    list_push_back(&ready_list, &t->elem);
+    now = rdtsc();
+    if (t->needs_lock != NULL) t->lock_wait_cycles += now - t->state_since;
+    t->state_since = now;
+    TRACE(THREAD_UNBLOCK, t->tid, t->priority, 0);
+    if (thread_mlfqs) {
+        update_recent_cpu(t, NULL);
+        update_priorities(t, NULL);
+    }
+    ready_queue_push(t);
     t->status = THREAD_READY;
     intr_set_level(old_level);
 }
 
+/* Frees babysitter B, which was allocated by thread_create(). */
+void thread_free_babysitter(struct babysitter *b) { kmem_cache_free(babysitter_cache, b); }
+
 /* Returns the name of the running thread. */
 const char *thread_name(void) { return thread_current()->name; }
 
@@ -322,26 +475,87 @@ void thread_yield(void) {
     ASSERT(!intr_context());
 
     old_level = intr_disable();
-    if (cur != idle_thread) list_push_back(&ready_list, &cur->elem);
+    if (cur != idle_thread) ready_queue_push(cur);
     cur->status = THREAD_READY;
     schedule();
     intr_set_level(old_level);
 }
 
-/* updates recent cpu for thread*/
+/* Applies CNT decays by coefficient COEFF to T's recent_cpu in
+   O(log CNT) steps, by repeatedly squaring the map
+   recent_cpu -> COEFF × recent_cpu + nice. */
+static void decay_repeat(struct thread *t, fixed_point_t coeff, unsigned cnt) {
+    fixed_point_t a = coeff, b = fix_int(t->nice);
+
+    for (; cnt != 0; cnt >>= 1) {
+        if (cnt & 1) t->recent_cpu = fix_add(fix_mul(a, t->recent_cpu), b);
+        b = fix_add(fix_mul(a, b), b);
+        a = fix_mul(a, a);
+    }
+}
+
+/* Brings T's recent cpu up to date by applying every decay it
+   has missed since it was last examined. */
 void update_recent_cpu(struct thread *t, void *aux UNUSED) {
     // recent_cpu = (2 × load_avg)/(2 × load_avg + 1) × recent_cpu + nice
-    fixed_point_t a = fix_mul(fix_int(2), load_average);
-    fixed_point_t b = fix_add(fix_mul(fix_int(2), load_average), fix_int(1));
-    t->recent_cpu = fix_add(fix_mul(fix_div(a, b), t->recent_cpu), fix_int(t->nice));
+    unsigned epoch = t->decay_epoch;
+
+    if (decay_epoch - epoch > DECAY_HISTORY) {
+        unsigned oldest = decay_epoch - DECAY_HISTORY;
+        decay_repeat(t, decay_coeffs[oldest % DECAY_HISTORY], oldest - epoch);
+        epoch = oldest;
+    }
+    for (; epoch != decay_epoch; epoch++)
+        t->recent_cpu = fix_add(fix_mul(decay_coeffs[epoch % DECAY_HISTORY], t->recent_cpu),
+                                fix_int(t->nice));
+    t->decay_epoch = decay_epoch;
 }
 
-/* updates priority for thread */
-void update_priorities(struct thread *t, void *aux UNUSED) {
+/* Returns the mlfqs priority for T, clamped to a valid ready
+   queue index. */
+static int mlfqs_priority(struct thread *t) {
     // priority = PRI_MAX − (recent_cpu/4) − (nice × 2)
     fixed_point_t primax = fix_int(PRI_MAX);
     fixed_point_t x = fix_sub(primax, fix_div(t->recent_cpu, fix_int(4)));
-    t->priority = fix_trunc(fix_sub(x, fix_mul(fix_int(t->nice), fix_int(2))));
+    int priority = fix_trunc(fix_sub(x, fix_mul(fix_int(t->nice), fix_int(2))));
+
+    if (priority < PRI_MIN)
+        priority = PRI_MIN;
+    else if (priority > PRI_MAX)
+        priority = PRI_MAX;
+    return priority;
+}
+
+/* updates priority for thread */
+void update_priorities(struct thread *t, void *aux UNUSED) {
+    thread_set_effective_priority(t, mlfqs_priority(t));
+}
+
+/* Sets T's effective (possibly donated) priority to PRIORITY.  If
+   T is waiting on a ready queue, it is moved to the tail of the
+   queue for its new priority.  Must be called with interrupts
+   off. */
+void thread_set_effective_priority(struct thread *t, int priority) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+    if (t->priority == priority) return;
+
+    if (t->status == THREAD_READY) {
+        ready_queue_remove(t);
+        t->priority = priority;
+        ready_queue_push(t);
+    } else {
+        t->priority = priority;
+    }
+}
+
+/* Donates DONOR's priority to RECIPIENT, which holds a lock
+   that DONOR is waiting for.  Must be called with interrupts
+   off. */
+void thread_donate_priority(struct thread *donor, struct thread *recipient) {
+    TRACE(DONATE, donor->tid, recipient->tid, donor->priority);
+    thread_set_effective_priority(recipient, donor->priority);
 }
 
 /* Invoke function 'func' on all threads, passing along 'aux'.
@@ -382,8 +596,20 @@ void thread_set_priority(int new_priority) {
 /* Returns the current thread's priority. */
 int thread_get_priority(void) { return thread_current()->priority; }
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED) { thread_current()->nice = nice; }
+/* Sets the current thread's nice value to NICE and recomputes its
+   priority, yielding if it no longer has the highest priority. */
+void thread_set_nice(int nice) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level = intr_disable();
+    int old_priority = cur->priority;
+
+    cur->nice = nice;
+    if (thread_mlfqs) {
+        update_priorities(cur, NULL);
+        if (cur->priority < old_priority) thread_yield();
+    }
+    intr_set_level(old_level);
+}
 
 /* Returns the current thread's nice value. */
 int thread_get_nice(void) { return thread_current()->nice; }
@@ -409,9 +635,20 @@ static void idle(void *idle_started_ UNUSED) {
     sema_up(idle_started);
 
     for (;;) {
-        /* Let someone else run. */
+        /* Let someone else run, if anyone is ready.  If the
+           periodic tick was stopped while we were halted, account
+           for the ticks we slept through first.  If no one is
+           ready, the interrupt that woke us may just have armed
+           the next one-shot, and the tick can stay stopped. */
         intr_disable();
-        thread_block();
+        if (ready_cnt != 0) {
+            timer_idle_exit();
+            thread_block();
+        }
+
+        /* Nothing else is ready to run.  Stop the periodic tick
+           until the next timer event is due. */
+        timer_idle_enter();
 
         /* Re-enable interrupts and wait for the next one.
 
@@ -438,7 +675,9 @@ static void kernel_thread(thread_func *function, void *aux) {
     thread_exit(); /* If function() returns, kill the thread. */
 }
 
-/* Returns the running thread. */
+/* Returns the running thread.  Unlike thread_current(), does not
+   check that it is a valid, running thread, so it also works
+   while the scheduler is switching threads. */
 struct thread *running_thread(void) {
     uint32_t *esp;
 
@@ -470,6 +709,7 @@ static void init_thread(struct thread *t, const char *name, int priority) {
     t->base_priority = priority;
     t->nice = running_thread()->nice;
     t->recent_cpu = running_thread()->recent_cpu;
+    t->decay_epoch = decay_epoch;
     t->needs_lock = NULL;
     list_init(&t->held_locks);
     list_init(&t->children);
@@ -492,14 +732,27 @@ static void *alloc_frame(struct thread *t, size_t size) {
     return t->stack;
 }
 
-/* Returns true if priority of A is less than priority of B, false
-   otherwise. */
-static bool priority_less(const struct list_elem *a_, const struct list_elem *b_,
-                          void *aux UNUSED) {
-    const struct thread *a = list_entry(a_, struct thread, elem);
-    const struct thread *b = list_entry(b_, struct thread, elem);
+/* Appends T to the tail of the ready queue for its priority and
+   marks that queue nonempty. */
+static void ready_queue_push(struct thread *t) {
+    int level = t->priority - PRI_MIN;
+
+    ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+    list_push_back(&ready_queues[level], &t->elem);
+    ready_mask[level / READY_MASK_BITS] |= 1u << (level % READY_MASK_BITS);
+    ready_cnt++;
+}
+
+/* Removes T from the ready queue for its priority, clearing the
+   queue's bit in ready_mask if it is now empty. */
+static void ready_queue_remove(struct thread *t) {
+    int level = t->priority - PRI_MIN;
 
-    return a->priority < b->priority;
+    list_remove(&t->elem);
+    if (list_empty(&ready_queues[level]))
+        ready_mask[level / READY_MASK_BITS] &= ~(1u << (level % READY_MASK_BITS));
+    ready_cnt--;
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -507,16 +760,38 @@ static bool priority_less(const struct list_elem *a_, const struct list_elem *b_
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
    idle_thread.
-   TODO: We need to check this one out
-   */
+
+   The highest nonempty queue is found by scanning ready_mask from
+   the top word down, so the cost does not depend on how many
+   threads are ready.  Threads of equal priority run in FIFO
+   order.
+
+   Under the mlfqs scheduler, a thread may have missed decays
+   since it was queued.  If catching up changes its priority, it
+   is requeued at the new priority and the search starts over.
+   This happens at most once per thread per decay. */
 static struct thread *next_thread_to_run(void) {
-    if (list_empty(&ready_list))
-        return idle_thread;
-    else {
-        struct list_elem *max_elem = list_max(&ready_list, priority_less, NULL);
-        list_remove(max_elem);
-        return list_entry(max_elem, struct thread, elem);
-    }
+    int word;
+
+    for (word = READY_MASK_CNT - 1; word >= 0; word--)
+        if (ready_mask[word] != 0) {
+            int level = word * READY_MASK_BITS + (READY_MASK_BITS - 1) -
+                        __builtin_clz(ready_mask[word]);
+            struct thread *t =
+                list_entry(list_front(&ready_queues[level]), struct thread, elem);
+            if (thread_mlfqs && t->decay_epoch != decay_epoch) {
+                int old_priority = t->priority;
+                update_recent_cpu(t, NULL);
+                update_priorities(t, NULL);
+                if (t->priority != old_priority) {
+                    word = READY_MASK_CNT;
+                    continue;
+                }
+            }
+            ready_queue_remove(t);
+            return t;
+        }
+    return idle_thread;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -578,7 +853,22 @@ static void schedule(void) {
     ASSERT(cur->status != THREAD_RUNNING);
     ASSERT(is_thread(next));
 
-    if (cur != next) prev = switch_threads(cur, next);
+    if (cur != next) {
+        uint64_t now = rdtsc();
+
+        if (cur->status == THREAD_READY) {
+            cur->preempted_switches++;
+            cur->state_since = now;
+        } else if (cur->status == THREAD_BLOCKED) {
+            cur->voluntary_switches++;
+            cur->state_since = now;
+        }
+        if (next != idle_thread) next->ready_wait_cycles += now - next->state_since;
+        next->sched_cnt++;
+        TRACE(SWITCH, next->tid, next->priority, cur->status);
+
+        prev = switch_threads(cur, next);
+    }
     thread_schedule_tail(prev);
 }
 
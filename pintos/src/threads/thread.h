@@ -92,21 +92,46 @@ struct thread {
     int priority;              /* Priority. */
     int base_priority;
     struct list_elem allelem;  /* List element for all threads list. */
-    int64_t wake_up_tick;      /* Tick time for thread to wake up */
-    struct list_elem nap_elem; /* List element for nap room list */
     int nice;                  /* Niceness of the thread  */
     fixed_point_t recent_cpu;  /* Recent CPU */
+    unsigned decay_epoch;      /* Last recent_cpu decay applied. */
+
+    /* Scheduler accounting, owned by thread.c. */
+    unsigned run_ticks;          /* Timer ticks spent running. */
+    unsigned sched_cnt;          /* Times switched onto the CPU. */
+    unsigned voluntary_switches; /* Times switched out by blocking. */
+    unsigned preempted_switches; /* Times switched out while runnable. */
+    uint64_t lock_wait_cycles;   /* TSC cycles blocked on locks. */
+    uint64_t ready_wait_cycles;  /* TSC cycles ready but not running. */
+    uint64_t state_since;        /* TSC when last blocked or readied. */
+    unsigned syscall_cnt;        /* System calls made, by syscall.c. */
 
     struct lock *needs_lock; /* Lock thread is waitig on */
     struct list held_locks;  /* List to store locks */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem; /* List element. */
+    bool interruptible;    /* Blocked in sema_down_interruptible()? */
+    bool interrupted;      /* Interruptible waits fail at once. */
 
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;             /* Page directory. */
     struct list children;          /* List to store all children threads */
     struct babysitter *babysitter; /* Struct to store baby sitter's info */
+    struct thread *leader;         /* Main thread of our process. */
+    uint8_t *user_stack;           /* Stack page, if not a main thread. */
+    int stack_slot;                /* Index of user_stack. */
+
+    /* Owned by userprog/process.c, used only in a main thread, on
+       behalf of its whole process. */
+    struct lock process_lock;   /* Protects the members below. */
+    struct list threads;        /* Babysitters of the other threads. */
+    uint32_t stack_slots;       /* Bitmap of user stacks in use. */
+    bool exiting;               /* Exit() called or a thread killed. */
+    uint8_t *heap_start;        /* Start of the sbrk() heap. */
+    uint8_t *heap_break;        /* Current end of the heap. */
+    unsigned std_redirects;     /* Redirected fds 0 and 1, by syscall.c. */
+    struct aio_ctx *aio;        /* Asynchronous I/O state, by aio.c. */
 
     block_sector_t current_directory;
 
@@ -123,15 +148,19 @@ void thread_init(void);
 void thread_start(void);
 
 void thread_tick(void);
+void thread_idle_tick(void);
 void thread_print_stats(void);
+void thread_print_accounting(void);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
 
 void thread_block(void);
 void thread_unblock(struct thread *);
+void thread_free_babysitter(struct babysitter *);
 
 struct thread *thread_current(void);
+struct thread *running_thread(void);
 tid_t thread_tid(void);
 const char *thread_name(void);
 
@@ -143,6 +172,8 @@ typedef void thread_action_func(struct thread *t, void *aux);
 void thread_foreach(thread_action_func *, void *);
 void update_recent_cpu(struct thread *t, void *aux);
 void update_priorities(struct thread *t, void *aux);
+void thread_set_effective_priority(struct thread *t, int priority);
+void thread_donate_priority(struct thread *donor, struct thread *recipient);
 void update_load_average(void);
 
 int thread_get_priority(void);
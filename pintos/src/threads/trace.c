@@ -0,0 +1,168 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <stdio.h>
+#include "devices/serial.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+#include "threads/vaddr.h"
+
+/* Tracepoints.
+
+   TRACE() call sites record an event id and three integer
+   arguments, stamped with the timer tick count, the time-stamp
+   counter and the running thread, into a ring buffer that keeps
+   the most recent TRACE_SIZE events.  Unlike printf(), this
+   takes no lock and does no I/O, so it barely perturbs the
+   timing being traced.
+
+   At shutdown, trace_dump() writes the ring, oldest record
+   first, straight to the serial port as raw trace_records
+   following a header line:
+
+       Trace: COUNT records of SIZE bytes, TOTAL recorded, TIMER_FREQ Hz
+
+   utils/pintos-trace finds the header in a run's output and
+   decodes the records into a timeline.
+
+   trace_print_sched() prints the most recent scheduler events
+   from the ring as text while the kernel runs, for the
+   sched_dump() syscall. */
+
+/* If true, record tracepoints.
+   Controlled by kernel command-line option "-trace". */
+bool trace_enabled;
+
+#define TRACE_PAGES 64 /* Pages of records. */
+#define TRACE_SIZE (TRACE_PAGES * PGSIZE / sizeof(struct trace_record))
+
+static struct trace_record *ring;
+static unsigned head; /* Total records ever written. */
+
+/* Allocates the trace buffer, if tracing is enabled. */
+void trace_init(void) {
+    if (!trace_enabled) return;
+
+    ring = palloc_get_multiple(0, TRACE_PAGES);
+    if (ring == NULL) {
+        printf("trace: not enough memory, tracing disabled\n");
+        trace_enabled = false;
+    }
+}
+
+/* Records EVENT with arguments A, B and C.  May be called with
+   interrupts on or off, including from interrupt handlers. */
+void trace_record(enum trace_event event, uint32_t a, uint32_t b, uint32_t c) {
+    struct trace_record *r;
+    enum intr_level old_level;
+
+    ASSERT(event < TRACE_EVENT_CNT);
+
+    old_level = intr_disable();
+    if (ring != NULL) {
+        r = &ring[head++ % TRACE_SIZE];
+        r->tsc = rdtsc();
+        r->ticks = timer_ticks();
+        r->tid = running_thread()->tid;
+        r->event = event;
+        r->pad = 0;
+        r->args[0] = a;
+        r->args[1] = b;
+        r->args[2] = c;
+    }
+    intr_set_level(old_level);
+}
+
+/* Writes the trace buffer to the serial port.  Recording stops
+   for good, so that the dump does not trace itself; the buffer
+   is not freed, since this happens only at shutdown. */
+void trace_dump(void) {
+    struct trace_record *records;
+    enum intr_level old_level;
+    unsigned first, cnt;
+
+    old_level = intr_disable();
+    records = ring;
+    ring = NULL;
+    trace_enabled = false;
+    intr_set_level(old_level);
+    if (records == NULL) return;
+
+    cnt = head < TRACE_SIZE ? head : TRACE_SIZE;
+    first = head - cnt;
+    printf("Trace: %u records of %zu bytes, %u recorded, %d Hz\n", cnt,
+           sizeof(struct trace_record), head, TIMER_FREQ);
+
+    /* The ring wraps at most once. */
+    if (first % TRACE_SIZE + cnt <= TRACE_SIZE)
+        serial_putbuf((const uint8_t *)&records[first % TRACE_SIZE], cnt * sizeof *records);
+    else {
+        unsigned tail = TRACE_SIZE - first % TRACE_SIZE;
+        serial_putbuf((const uint8_t *)&records[first % TRACE_SIZE], tail * sizeof *records);
+        serial_putbuf((const uint8_t *)records, (cnt - tail) * sizeof *records);
+    }
+    printf("\nTrace: end\n");
+}
+
+/* Returns true if EVENT is recorded by the scheduler. */
+static bool is_sched_event(uint16_t event) {
+    return (event == TRACE_SWITCH || event == TRACE_THREAD_BLOCK ||
+            event == TRACE_THREAD_UNBLOCK || event == TRACE_DONATE);
+}
+
+/* Prints the most recent scheduler events in the trace buffer,
+   oldest first, as many as fit in a page. */
+void trace_print_sched(void) {
+    static const char *status_names[] = {"running", "ready", "blocked", "dying"};
+    struct trace_record *snap;
+    size_t cnt = 0, max = PGSIZE / sizeof *snap;
+    enum intr_level old_level;
+    unsigned i;
+
+    if (!trace_enabled) {
+        printf("Scheduler events: not recorded without -trace\n");
+        return;
+    }
+
+    /* Events keep arriving while we print, so take a copy of the
+       newest ones, scanning backward from the head. */
+    snap = palloc_get_page(0);
+    if (snap == NULL) return;
+    old_level = intr_disable();
+    if (ring != NULL) {
+        unsigned first = head < TRACE_SIZE ? 0 : head - TRACE_SIZE;
+        for (i = head; i > first && cnt < max; i--) {
+            struct trace_record *r = &ring[(i - 1) % TRACE_SIZE];
+            if (is_sched_event(r->event)) snap[max - ++cnt] = *r;
+        }
+    }
+    intr_set_level(old_level);
+
+    printf("Scheduler events (ticks tid: event):\n");
+    for (i = max - cnt; i < max; i++) {
+        struct trace_record *r = &snap[i];
+
+        printf("  %u %d: ", r->ticks, r->tid);
+        switch (r->event) {
+        case TRACE_SWITCH:
+            printf("switch to %u (priority %u), left %s\n", r->args[0], r->args[1],
+                   r->args[2] <= THREAD_DYING ? status_names[r->args[2]] : "?");
+            break;
+        case TRACE_THREAD_BLOCK:
+            if (r->args[0] != 0)
+                printf("block on lock held by %u (priority %u)\n", r->args[0], r->args[1]);
+            else
+                printf("block (priority %u)\n", r->args[1]);
+            break;
+        case TRACE_THREAD_UNBLOCK:
+            printf("unblock %u (priority %u)\n", r->args[0], r->args[1]);
+            break;
+        case TRACE_DONATE:
+            printf("%u donates priority %u to %u\n", r->args[0], r->args[2], r->args[1]);
+            break;
+        }
+    }
+    palloc_free_page(snap);
+}
@@ -0,0 +1,55 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Tracepoint events.  Events that start an interval are paired
+   with the event that ends it by utils/pintos-trace, which must
+   list the same events in the same order. */
+enum trace_event {
+    TRACE_SYSCALL,        /* Syscall NUMBER(ARG1, ARG2) entered. */
+    TRACE_SYSCALL_RETURN, /* Syscall NUMBER returned EAX. */
+    TRACE_BLOCK_READ,     /* Read of SECTOR from block TYPE started. */
+    TRACE_BLOCK_WRITE,    /* Write of SECTOR to block TYPE started. */
+    TRACE_BLOCK_DONE,     /* Block TYPE finished with SECTOR. */
+    TRACE_PAGE_FAULT,     /* Fault at ADDR by EIP with ERROR_CODE. */
+    TRACE_SWITCH,         /* Switched to TID with PRIORITY, leaving STATUS. */
+    TRACE_LOCK_WAIT,      /* Started waiting for LOCK held by TID. */
+    TRACE_LOCK_ACQUIRE,   /* Acquired LOCK after waiting. */
+    TRACE_THREAD_BLOCK,   /* Blocked, on a lock held by TID if nonzero,
+                             with PRIORITY. */
+    TRACE_THREAD_UNBLOCK, /* Unblocked thread TID with PRIORITY. */
+    TRACE_DONATE,         /* DONOR donated PRIORITY to RECIPIENT. */
+    TRACE_EVENT_CNT
+};
+
+/* One recorded event, as dumped in binary at shutdown. */
+struct trace_record {
+    uint64_t tsc;     /* Time-stamp counter. */
+    uint32_t ticks;   /* Timer ticks since boot. */
+    int32_t tid;      /* Running thread. */
+    uint16_t event;   /* An enum trace_event. */
+    uint16_t pad;
+    uint32_t args[3]; /* Event arguments. */
+};
+
+/* If true, record tracepoints.  Controlled by kernel
+   command-line option "-trace". */
+extern bool trace_enabled;
+
+void trace_init(void);
+void trace_record(enum trace_event, uint32_t, uint32_t, uint32_t);
+void trace_dump(void);
+void trace_print_sched(void);
+
+/* Records EVENT, a TRACE_* name without the prefix, with
+   arguments A, B and C, if tracing is enabled. */
+#define TRACE(EVENT, A, B, C)                                              \
+    do {                                                                   \
+        if (trace_enabled)                                                 \
+            trace_record(TRACE_##EVENT, (uint32_t)(A), (uint32_t)(B),      \
+                         (uint32_t)(C));                                   \
+    } while (0)
+
+#endif /* threads/trace.h */
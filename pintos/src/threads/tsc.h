@@ -0,0 +1,17 @@
+#ifndef THREADS_TSC_H
+#define THREADS_TSC_H
+
+#include <stdint.h>
+
+/* Returns the CPU's time-stamp counter, which counts clock
+   cycles since reset.  timer_tsc_to_ns() converts differences
+   between readings into nanoseconds. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* threads/tsc.h */
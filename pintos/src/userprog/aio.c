@@ -0,0 +1,292 @@
+#include "userprog/aio.h"
+#include <aio.h>
+#include <debug.h>
+#include <list.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+
+/* Asynchronous I/O.
+
+   A process's rings live in a user page that the kernel also
+   reaches through its own mapping of physical memory, so the
+   worker threads that carry out requests can post completions
+   without the process's page directory.  aio_enter() copies each
+   new request out of the ring, reopens its file so that closing
+   the fd cannot pull the file out from under a worker, and
+   queues it for the workers.
+
+   Workers move data through a page-sized bounce buffer: the file
+   system runs without any user page directory, and the copy to
+   or from user memory is made under the process's process_lock,
+   which is also held wherever user pages are unmapped while the
+   process runs.  A buffer that is not mapped when the copy is
+   made fails the request rather than the kernel.
+
+   Before its page directory is destroyed, an exiting process
+   waits for its requests to finish. */
+
+/* Worker threads.  File system access is serialized by io_lock,
+   so more workers would only queue up there. */
+#define WORKER_CNT 2
+
+/* User address of the rings, just past the largest heap. */
+#define RING_ADDR HEAP_LIMIT
+
+/* A process's asynchronous I/O state. */
+struct aio_ctx {
+    struct aio_ring *ring;     /* Rings, through the kernel mapping. */
+    struct thread *leader;     /* Main thread of the process. */
+    uint32_t *pagedir;         /* Process's page directory. */
+    struct lock lock;          /* Protects everything below. */
+    struct condition progress; /* Signaled when a request completes. */
+    unsigned pending;          /* Requests not yet completed. */
+};
+
+/* A request queued for the workers. */
+struct aio_request {
+    struct list_elem elem; /* Element in request_queue. */
+    struct aio_ctx *ctx;   /* Owning process. */
+    struct file *file;     /* Reopened file. */
+    struct aio_sqe sqe;    /* The request itself. */
+};
+
+static struct list request_queue;   /* Requests waiting for a worker. */
+static struct lock queue_lock;      /* Protects request_queue. */
+static struct condition queue_cond; /* Signaled when a request arrives. */
+static bool workers_started;        /* Have workers been created? */
+
+static thread_func worker NO_RETURN;
+static void close_file(struct file *);
+static int do_request(struct aio_request *, uint8_t *bounce);
+static bool copy_user(struct aio_ctx *, uint8_t *udst, const uint8_t *usrc, uint8_t *kbuf,
+                      size_t size);
+static void post_completion(struct aio_ctx *, uint32_t user_data, int result);
+
+/* Initializes the request queue. */
+void aio_init(void) {
+    list_init(&request_queue);
+    lock_init_named(&queue_lock, "aio queue");
+    cond_init(&queue_cond);
+}
+
+/* Maps rings into the current process, if they are not already,
+   and returns their user address, or a null pointer if memory is
+   not available. */
+void *aio_setup(void) {
+    struct thread *leader = thread_current()->leader;
+    struct aio_ctx *ctx;
+    void *kpage;
+    int i;
+
+    lock_acquire(&queue_lock);
+    if (!workers_started) {
+        for (i = 0; i < WORKER_CNT; i++) thread_create("aio", PRI_DEFAULT, worker, NULL);
+        workers_started = true;
+    }
+    lock_release(&queue_lock);
+
+    lock_acquire(&leader->process_lock);
+    if (leader->aio == NULL) {
+        ctx = malloc(sizeof *ctx);
+        kpage = palloc_get_page(PAL_USER | PAL_ZERO);
+        if (ctx == NULL || kpage == NULL ||
+            !pagedir_set_page(leader->pagedir, RING_ADDR, kpage, true)) {
+            free(ctx);
+            if (kpage != NULL) palloc_free_page(kpage);
+            lock_release(&leader->process_lock);
+            return NULL;
+        }
+        ctx->ring = kpage;
+        ctx->leader = leader;
+        ctx->pagedir = leader->pagedir;
+        lock_init(&ctx->lock);
+        cond_init(&ctx->progress);
+        ctx->pending = 0;
+        leader->aio = ctx;
+    }
+    lock_release(&leader->process_lock);
+    return RING_ADDR;
+}
+
+/* Takes up to TO_SUBMIT new requests from the current process's
+   submission ring and starts them, then waits until at least
+   MIN_COMPLETE completions are ready to consume or nothing is
+   left in flight.  Returns the number of requests taken, or -1
+   if the process has no rings. */
+int aio_enter(unsigned to_submit, unsigned min_complete) {
+    struct aio_ctx *ctx = thread_current()->leader->aio;
+    struct aio_ring *ring;
+    unsigned submitted = 0;
+
+    if (ctx == NULL) return -1;
+    ring = ctx->ring;
+
+    lock_acquire(&ctx->lock);
+    while (submitted < to_submit && ring->sq_head != ring->sq_tail &&
+           ctx->pending + (ring->cq_tail - ring->cq_head) < AIO_ENTRIES) {
+        struct aio_sqe sqe;
+        struct file *file = NULL;
+        struct aio_request *r;
+
+        barrier();
+        sqe = ring->sqes[ring->sq_head % AIO_ENTRIES];
+        ring->sq_head++;
+        submitted++;
+
+        /* Check the request and reopen its file. */
+        if ((sqe.op == AIO_READ || sqe.op == AIO_WRITE) && is_user_vaddr(sqe.buffer) &&
+            sqe.size <= (size_t)((uint8_t *)PHYS_BASE - (uint8_t *)sqe.buffer))
+            file = syscall_reopen_fd(sqe.fd);
+        r = file != NULL ? malloc(sizeof *r) : NULL;
+        if (r == NULL) {
+            close_file(file);
+            post_completion(ctx, sqe.user_data, -1);
+            continue;
+        }
+
+        r->ctx = ctx;
+        r->file = file;
+        r->sqe = sqe;
+        ctx->pending++;
+        lock_acquire(&queue_lock);
+        list_push_back(&request_queue, &r->elem);
+        cond_signal(&queue_cond, &queue_lock);
+        lock_release(&queue_lock);
+    }
+
+    while (ring->cq_tail - ring->cq_head < min_complete && ctx->pending > 0)
+        cond_wait(&ctx->progress, &ctx->lock);
+    lock_release(&ctx->lock);
+    return submitted;
+}
+
+/* Waits for LEADER's process's requests to finish and frees its
+   asynchronous I/O state.  The rings themselves are freed along
+   with the page directory. */
+void aio_destroy(struct thread *leader) {
+    struct aio_ctx *ctx = leader->aio;
+
+    if (ctx == NULL) return;
+    lock_acquire(&ctx->lock);
+    while (ctx->pending > 0) cond_wait(&ctx->progress, &ctx->lock);
+    lock_release(&ctx->lock);
+    leader->aio = NULL;
+    free(ctx);
+}
+
+/* A worker thread, which carries out requests one at a time. */
+static void worker(void *aux UNUSED) {
+    uint8_t *bounce = palloc_get_page(PAL_ASSERT);
+
+    for (;;) {
+        struct aio_request *r;
+        struct aio_ctx *ctx;
+        uint32_t user_data;
+        int result;
+
+        lock_acquire(&queue_lock);
+        while (list_empty(&request_queue)) cond_wait(&queue_cond, &queue_lock);
+        r = list_entry(list_pop_front(&request_queue), struct aio_request, elem);
+        lock_release(&queue_lock);
+
+        result = do_request(r, bounce);
+        close_file(r->file);
+        ctx = r->ctx;
+        user_data = r->sqe.user_data;
+        free(r);
+
+        lock_acquire(&ctx->lock);
+        ctx->pending--;
+        post_completion(ctx, user_data, result);
+        lock_release(&ctx->lock);
+    }
+}
+
+/* Carries out request R, using BOUNCE, a page, to hold data on
+   its way between the file and user memory.  Returns the number
+   of bytes transferred, or -1 if the first chunk of the user
+   buffer is not mapped. */
+static int do_request(struct aio_request *r, uint8_t *bounce) {
+    uint8_t *buffer = r->sqe.buffer;
+    off_t ofs = r->sqe.offset;
+    size_t done = 0;
+
+    while (done < r->sqe.size) {
+        size_t chunk = r->sqe.size - done < PGSIZE ? r->sqe.size - done : PGSIZE;
+        off_t cnt;
+
+        if (r->sqe.op == AIO_READ) {
+            lock_acquire(&io_lock);
+            cnt = file_read_at(r->file, bounce, chunk, ofs + done);
+            lock_release(&io_lock);
+            if (cnt > 0 && !copy_user(r->ctx, buffer + done, NULL, bounce, cnt)) cnt = -1;
+        } else if (copy_user(r->ctx, NULL, buffer + done, bounce, chunk)) {
+            lock_acquire(&io_lock);
+            cnt = file_write_at(r->file, bounce, chunk, ofs + done);
+            lock_release(&io_lock);
+        } else
+            cnt = -1;
+        if (cnt < 0) return done > 0 ? (int)done : -1;
+        done += cnt;
+        if ((size_t)cnt < chunk) break;
+    }
+    return done;
+}
+
+/* Closes FILE, if it is nonnull. */
+static void close_file(struct file *file) {
+    lock_acquire(&io_lock);
+    file_close(file);
+    lock_release(&io_lock);
+}
+
+/* Copies SIZE bytes between KBUF and the user memory of CTX's
+   process: to UDST if it is nonnull, otherwise from USRC.
+   Returns false if any of the user memory is not mapped. */
+static bool copy_user(struct aio_ctx *ctx, uint8_t *udst, const uint8_t *usrc, uint8_t *kbuf,
+                      size_t size) {
+    const uint8_t *uaddr = udst != NULL ? udst : usrc;
+    bool ok = true;
+
+    lock_acquire(&ctx->leader->process_lock);
+    while (size > 0) {
+        size_t page_left = PGSIZE - pg_ofs(uaddr);
+        size_t n = size < page_left ? size : page_left;
+        uint8_t *kpage = pagedir_get_page(ctx->pagedir, uaddr);
+
+        if (kpage == NULL) {
+            ok = false;
+            break;
+        }
+        if (udst != NULL)
+            memcpy(kpage, kbuf, n);
+        else
+            memcpy(kbuf, kpage, n);
+        uaddr += n;
+        kbuf += n;
+        size -= n;
+    }
+    lock_release(&ctx->leader->process_lock);
+    return ok;
+}
+
+/* Posts a completion for the request with USER_DATA to CTX's
+   completion ring.  CTX's lock must be held. */
+static void post_completion(struct aio_ctx *ctx, uint32_t user_data, int result) {
+    struct aio_ring *ring = ctx->ring;
+    struct aio_cqe *cqe = &ring->cqes[ring->cq_tail % AIO_ENTRIES];
+
+    ASSERT(lock_held_by_current_thread(&ctx->lock));
+    cqe->user_data = user_data;
+    cqe->result = result;
+    barrier();
+    ring->cq_tail++;
+    cond_broadcast(&ctx->progress, &ctx->lock);
+}
@@ -0,0 +1,14 @@
+#ifndef USERPROG_AIO_H
+#define USERPROG_AIO_H
+
+#include "threads/thread.h"
+
+/* Asynchronous I/O rings.  See lib/aio.h for the interface seen
+   by user programs. */
+
+void aio_init(void);
+void *aio_setup(void);
+int aio_enter(unsigned to_submit, unsigned min_complete);
+void aio_destroy(struct thread *leader);
+
+#endif /* userprog/aio.h */
@@ -4,6 +4,7 @@
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -142,6 +143,7 @@ page_fault (struct intr_frame *f)
 
   /* Count page faults. */
   page_fault_cnt++;
+  TRACE (PAGE_FAULT, fault_addr, f->eip, f->error_code);
 
   /* Determine cause. */
   not_present = (f->error_code & PF_P) == 0;
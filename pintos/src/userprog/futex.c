@@ -0,0 +1,114 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Futexes ("fast user-space mutexes").
+
+   User-space locks keep their state in an ordinary int and
+   change it with atomic instructions, entering the kernel only
+   to sleep when the lock is taken or to wake a sleeper when it
+   is released.  futex_wait() puts the caller to sleep on an
+   address, but only if the int there still holds the value the
+   caller expects; futex_wake() wakes threads sleeping on an
+   address.  Checking the value and going to sleep happen under
+   the same lock as waking, so a wakeup that follows a change to
+   the int cannot slip in between and be lost.
+
+   A sleeping thread waits in one of a fixed number of buckets,
+   chosen by hashing its address space and address.  Threads
+   with different keys may share a bucket, so futex_wake() checks
+   each waiter's key. */
+
+/* Number of hash buckets. */
+#define BUCKET_CNT 64
+
+/* A bucket of sleeping threads. */
+struct bucket {
+    struct lock lock;    /* Protects waiters. */
+    struct list waiters; /* Sleeping threads, oldest first. */
+};
+
+/* A thread sleeping in futex_wait(). */
+struct waiter {
+    struct list_elem elem;   /* Element in bucket's waiters. */
+    uint32_t *pagedir;       /* Address space of... */
+    const int *uaddr;        /* ...the address slept on. */
+    struct semaphore wakeup; /* Upped by futex_wake(). */
+};
+
+static struct bucket buckets[BUCKET_CNT];
+
+/* Returns the bucket for UADDR in the running process. */
+static struct bucket *find_bucket(const int *uaddr) {
+    uintptr_t key = (uintptr_t)uaddr ^ (uintptr_t)thread_current()->pagedir;
+    return &buckets[hash_int(key) % BUCKET_CNT];
+}
+
+/* Initializes the buckets. */
+void futex_init(void) {
+    int i;
+
+    for (i = 0; i < BUCKET_CNT; i++) {
+        lock_init(&buckets[i].lock);
+        list_init(&buckets[i].waiters);
+    }
+}
+
+/* If the int at user address UADDR equals VAL, sleeps until
+   futex_wake() is called on UADDR and returns 0.  Otherwise
+   returns -1 at once, or once the process begins to exit.  UADDR must be mapped and aligned. */
+int futex_wait(const int *uaddr, int val) {
+    struct bucket *b = find_bucket(uaddr);
+    struct waiter w;
+
+    lock_acquire(&b->lock);
+    if (*uaddr != val) {
+        lock_release(&b->lock);
+        return -1;
+    }
+    w.pagedir = thread_current()->pagedir;
+    w.uaddr = uaddr;
+    sema_init(&w.wakeup, 0);
+    list_push_back(&b->waiters, &w.elem);
+    lock_release(&b->lock);
+
+    if (!sema_down_interruptible(&w.wakeup)) {
+        /* The process is exiting.  Unless futex_wake() got to us
+           first, we are still on the list. */
+        lock_acquire(&b->lock);
+        if (!sema_try_down(&w.wakeup)) {
+            list_remove(&w.elem);
+            lock_release(&b->lock);
+            return -1;
+        }
+        lock_release(&b->lock);
+    }
+    return 0;
+}
+
+/* Wakes up to CNT threads of the running process that are
+   sleeping on UADDR, oldest first, and returns how many were
+   woken. */
+int futex_wake(const int *uaddr, int cnt) {
+    struct bucket *b = find_bucket(uaddr);
+    uint32_t *pd = thread_current()->pagedir;
+    struct list_elem *e;
+    int woken = 0;
+
+    lock_acquire(&b->lock);
+    for (e = list_begin(&b->waiters); e != list_end(&b->waiters) && woken < cnt;) {
+        struct waiter *w = list_entry(e, struct waiter, elem);
+        e = list_next(e);
+        if (w->pagedir == pd && w->uaddr == uaddr) {
+            list_remove(&w->elem);
+            sema_up(&w->wakeup);
+            woken++;
+        }
+    }
+    lock_release(&b->lock);
+    return woken;
+}
@@ -0,0 +1,10 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+/* Wait queues keyed by user address, for user-space locks. */
+
+void futex_init(void);
+int futex_wait(const int *uaddr, int val);
+int futex_wake(const int *uaddr, int cnt);
+
+#endif /* userprog/futex.h */
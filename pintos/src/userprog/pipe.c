@@ -0,0 +1,139 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A pipe is a ring buffer that fills the rest of the page its
+   header sits in.  Readers sleep while it is empty and writers
+   while it is full.  Each end counts the file descriptors open on
+   it: once no writers remain, a reader that finds the buffer
+   empty sees end of file, and once no readers remain, writing
+   fails.  The pipe is freed when both counts reach zero. */
+struct pipe {
+    struct lock lock;           /* Protects all the members. */
+    struct condition not_empty; /* Signaled when data arrives. */
+    struct condition not_full;  /* Signaled when space frees up. */
+    unsigned readers;           /* Open read ends. */
+    unsigned writers;           /* Open write ends. */
+    size_t start;               /* Offset of the oldest byte. */
+    size_t used;                /* Number of bytes buffered. */
+    uint8_t data[];             /* Ring buffer. */
+};
+
+/* Capacity of a pipe's ring buffer. */
+#define PIPE_SIZE (PGSIZE - sizeof(struct pipe))
+
+/* Creates a pipe with one read end and one write end open.
+   Returns the pipe, or a null pointer if memory is not
+   available. */
+struct pipe *pipe_create(void) {
+    struct pipe *p = palloc_get_page(0);
+    if (p == NULL) return NULL;
+
+    lock_init(&p->lock);
+    cond_init(&p->not_empty);
+    cond_init(&p->not_full);
+    p->readers = 1;
+    p->writers = 1;
+    p->start = p->used = 0;
+    return p;
+}
+
+/* Opens another read end of P, or another write end if WRITER
+   is true. */
+void pipe_open(struct pipe *p, bool writer) {
+    lock_acquire(&p->lock);
+    if (writer)
+        p->writers++;
+    else
+        p->readers++;
+    lock_release(&p->lock);
+}
+
+/* Closes a read end of P, or a write end if WRITER is true,
+   waking up anyone who is waiting for the other end, and frees P
+   if that was its last end. */
+void pipe_close(struct pipe *p, bool writer) {
+    bool last;
+
+    lock_acquire(&p->lock);
+    if (writer) {
+        ASSERT(p->writers > 0);
+        if (--p->writers == 0) cond_broadcast(&p->not_empty, &p->lock);
+    } else {
+        ASSERT(p->readers > 0);
+        if (--p->readers == 0) cond_broadcast(&p->not_full, &p->lock);
+    }
+    last = p->readers == 0 && p->writers == 0;
+    lock_release(&p->lock);
+
+    if (last) palloc_free_page(p);
+}
+
+/* Reads up to SIZE bytes from P into BUFFER, waiting for data if
+   P is empty and still has writers.  Returns the number of bytes
+   read, which is 0 only at end of file, or -1 if the wait was
+   interrupted because the process is exiting. */
+int pipe_read(struct pipe *p, void *buffer, unsigned size) {
+    uint8_t *dst = buffer;
+    size_t cnt, ofs, chunk;
+
+    if (size == 0) return 0;
+
+    lock_acquire(&p->lock);
+    while (p->used == 0 && p->writers > 0)
+        if (!cond_wait_interruptible(&p->not_empty, &p->lock)) {
+            lock_release(&p->lock);
+            return -1;
+        }
+
+    /* Copy out everything available, in at most two pieces
+       because the data may wrap around the end of the ring. */
+    cnt = p->used < size ? p->used : size;
+    ofs = p->start;
+    chunk = cnt < PIPE_SIZE - ofs ? cnt : PIPE_SIZE - ofs;
+    memcpy(dst, p->data + ofs, chunk);
+    memcpy(dst + chunk, p->data, cnt - chunk);
+    p->start = (p->start + cnt) % PIPE_SIZE;
+    p->used -= cnt;
+
+    if (cnt > 0) cond_broadcast(&p->not_full, &p->lock);
+    lock_release(&p->lock);
+    return cnt;
+}
+
+/* Writes the SIZE bytes in BUFFER to P, waiting for room as
+   necessary.  Returns SIZE, or if every read end is closed or
+   the wait is interrupted because the process is exiting, the
+   number of bytes written before that happened or -1 if none
+   were. */
+int pipe_write(struct pipe *p, const void *buffer, unsigned size) {
+    const uint8_t *src = buffer;
+    size_t done = 0;
+
+    lock_acquire(&p->lock);
+    while (done < size) {
+        size_t room, cnt, ofs, chunk;
+
+        while (p->used == PIPE_SIZE && p->readers > 0)
+            if (!cond_wait_interruptible(&p->not_full, &p->lock)) break;
+        if (p->readers == 0 || p->used == PIPE_SIZE) break;
+
+        room = PIPE_SIZE - p->used;
+        cnt = size - done < room ? size - done : room;
+        ofs = (p->start + p->used) % PIPE_SIZE;
+        chunk = cnt < PIPE_SIZE - ofs ? cnt : PIPE_SIZE - ofs;
+        memcpy(p->data + ofs, src + done, chunk);
+        memcpy(p->data, src + done + chunk, cnt - chunk);
+        p->used += cnt;
+        done += cnt;
+
+        cond_broadcast(&p->not_empty, &p->lock);
+    }
+    lock_release(&p->lock);
+
+    return done > 0 || size == 0 ? (int)done : -1;
+}
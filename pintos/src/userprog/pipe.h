@@ -0,0 +1,15 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+
+/* A one-way byte stream between processes. */
+struct pipe;
+
+struct pipe *pipe_create(void);
+void pipe_open(struct pipe *, bool writer);
+void pipe_close(struct pipe *, bool writer);
+int pipe_read(struct pipe *, void *buffer, unsigned size);
+int pipe_write(struct pipe *, const void *buffer, unsigned size);
+
+#endif /* userprog/pipe.h */
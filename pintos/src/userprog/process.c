@@ -16,6 +16,7 @@
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "userprog/aio.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
 #include "userprog/syscall.h"
@@ -23,6 +24,10 @@
 
 // static struct semaphore temporary;
 static thread_func start_process NO_RETURN;
+static thread_func start_pthread NO_RETURN;
+static void pthread_exit_cleanup(void);
+static void join_all_threads(void);
+static void interrupt_thread(struct thread *, void *leader);
 static bool load(const char *cmdline, void (**eip)(void), void **esp);
 struct babysitter *getChildBabySitter(tid_t tid);
 
@@ -73,9 +78,16 @@ struct babysitter *getChildBabySitter(tid_t tid) {
    running. */
 static void start_process(void *file_name_) {
     char *file_name = file_name_;
+    struct thread *cur = thread_current();
     struct intr_frame if_;
     bool success;
 
+    /* We are the main thread of a new process, using stack slot 0. */
+    cur->leader = cur;
+    lock_init(&cur->process_lock);
+    list_init(&cur->threads);
+    cur->stack_slots = 1;
+
     /* Number of bytes needed to allocate data to the stack */
     int num_bytes = strlen(file_name) + 1;
     int word_align = 4 - (num_bytes % 4);
@@ -132,6 +144,10 @@ static void start_process(void *file_name_) {
 
     palloc_free_page(file_name);
 
+    /* Take our own ends of the parent's pipes while it is still
+       waiting for us to load. */
+    syscall_inherit_fds(thread_current()->babysitter->parent_tid);
+
     thread_current()->babysitter->load_success = true;
     sema_up(&thread_current()->babysitter->sema_loading);
 
@@ -157,17 +173,28 @@ static void start_process(void *file_name_) {
 int process_wait(tid_t child_tid) {
     struct babysitter *babysitter = getChildBabySitter(child_tid);
     if (babysitter != NULL) {
-        sema_down(&babysitter->sema_loading);
+        if (!sema_down_interruptible(&babysitter->sema_loading)) return -1;
         list_remove(&babysitter->child_elem);
     }
     return babysitter != NULL ? babysitter->exit_code : -1;
 }
 
-/* Free the current process's resources. */
+/* Free the current process's resources.  If the current thread
+   is not the main thread of its process, frees only the
+   thread's own resources instead. */
 void process_exit(void) {
     struct thread *cur = thread_current();
     uint32_t *pd;
 
+    if (cur->leader != NULL && cur->leader != cur) {
+        pthread_exit_cleanup();
+        return;
+    }
+    if (cur->leader != NULL) {
+        join_all_threads();
+        aio_destroy(cur);
+    }
+
     /* Destroy the current process's page directory and switch back
        to the kernel-only page directory. */
     pd = cur->pagedir;
@@ -187,7 +214,8 @@ void process_exit(void) {
     file_close(cur->babysitter->file);
 
     while (!list_empty(&cur->children)) {
-        free(list_entry(list_pop_front(&cur->children), struct babysitter, child_elem));
+        thread_free_babysitter(
+            list_entry(list_pop_front(&cur->children), struct babysitter, child_elem));
     }
 
     close_all_files(cur->tid);
@@ -355,12 +383,17 @@ bool load(const char *file_name, void (**eip)(void), void **esp) {
                     if (!load_segment(file, file_page, (void *)mem_page, read_bytes, zero_bytes,
                                       writable))
                         goto done;
+                    if ((uint8_t *)mem_page + read_bytes + zero_bytes > t->heap_start)
+                        t->heap_start = (uint8_t *)mem_page + read_bytes + zero_bytes;
                 } else
                     goto done;
                 break;
         }
     }
 
+    /* The heap starts out empty, just past the last segment. */
+    t->heap_break = t->heap_start;
+
     /* Set up stack. */
     if (!setup_stack(esp)) goto done;
 
@@ -500,3 +533,285 @@ static bool install_page(void *upage, void *kpage, bool writable) {
     return (pagedir_get_page(t->pagedir, upage) == NULL &&
             pagedir_set_page(t->pagedir, upage, kpage, writable));
 }
+
+/* Moves the current process's heap break by INCREMENT bytes,
+   mapping zeroed pages as the heap grows and unmapping them as it
+   shrinks.  Returns the previous break, or (void *) -1 if the
+   break would move outside the heap or memory runs out, in which
+   case the break is unchanged. */
+void *process_sbrk(intptr_t increment) {
+    struct thread *t = thread_current()->leader;
+    uint8_t *old_break, *new_break, *upage;
+
+    lock_acquire(&t->process_lock);
+    old_break = t->heap_break;
+    new_break = old_break + increment;
+    if (increment > 0 ? new_break < old_break || new_break > HEAP_LIMIT
+                      : new_break > old_break || new_break < t->heap_start) {
+        lock_release(&t->process_lock);
+        return (void *)-1;
+    }
+
+    if (increment > 0) {
+        /* Map pages from the first unmapped heap page up to the
+           page containing the last byte of the new heap. */
+        for (upage = pg_round_up(old_break); upage < new_break; upage += PGSIZE) {
+            uint8_t *kpage = palloc_get_page(PAL_USER | PAL_ZERO);
+            if (kpage == NULL || !install_page(upage, kpage, true)) {
+                if (kpage != NULL) palloc_free_page(kpage);
+
+                /* Undo what we mapped so far. */
+                while (upage > (uint8_t *)pg_round_up(old_break)) {
+                    upage -= PGSIZE;
+                    palloc_free_page(pagedir_get_page(t->pagedir, upage));
+                    pagedir_clear_page(t->pagedir, upage);
+                }
+                lock_release(&t->process_lock);
+                return (void *)-1;
+            }
+        }
+    } else {
+        /* Unmap whole pages that are now past the break. */
+        for (upage = pg_round_up(new_break); upage < old_break; upage += PGSIZE) {
+            palloc_free_page(pagedir_get_page(t->pagedir, upage));
+            pagedir_clear_page(t->pagedir, upage);
+        }
+    }
+
+    t->heap_break = new_break;
+    lock_release(&t->process_lock);
+    return old_break;
+}
+
+/* User threads.
+
+   The threads of a process share its main thread's page
+   directory, open files and heap.  Each other thread gets a
+   one-page user stack in its own slot between HEAP_LIMIT and the
+   main thread's stack, and a babysitter on its main thread's
+   `threads' list that pthread_join() waits on, just as wait()
+   does on a child process's.  The main thread's process_exit()
+   joins whatever threads are left before tearing the process
+   down.
+
+   When the process exits, process_kill_threads() marks it as
+   exiting and interrupts the blocking waits of its other threads,
+   and process_check_exit() stops each thread on its way back to
+   user mode, so that none of them, whether blocked in the kernel
+   or running in user mode, keeps the process from finishing. */
+
+/* Maximum threads per process, including the main thread, and
+   the address space set aside for each one's stack. */
+#define THREAD_MAX 32
+#define STACK_SPACING (((uint8_t *)PHYS_BASE - HEAP_LIMIT) / THREAD_MAX)
+
+/* Startup information for start_pthread(). */
+struct pthread_start {
+    struct thread *leader; /* Main thread of the process. */
+    void *stub;            /* User function that calls FUN(ARG). */
+    void *fun;
+    void *arg;
+    int slot; /* Stack slot reserved for the thread. */
+};
+
+/* Starts a thread in the current process that runs STUB(FUN, ARG)
+   in user mode.  Returns the new thread's tid, or TID_ERROR if
+   the process already has THREAD_MAX threads or memory is not
+   available. */
+tid_t process_pthread_create(void *stub, void *fun, void *arg) {
+    struct thread *leader = thread_current()->leader;
+    struct pthread_start start = {leader, stub, fun, arg, 0};
+    struct babysitter *b;
+    tid_t tid;
+
+    /* Reserve a stack slot. */
+    lock_acquire(&leader->process_lock);
+    while (start.slot < THREAD_MAX && (leader->stack_slots & (1u << start.slot))) start.slot++;
+    if (start.slot < THREAD_MAX) leader->stack_slots |= 1u << start.slot;
+    lock_release(&leader->process_lock);
+    if (start.slot == THREAD_MAX) return TID_ERROR;
+
+    tid = thread_create(leader->name, PRI_DEFAULT, start_pthread, &start);
+    if (tid == TID_ERROR) {
+        lock_acquire(&leader->process_lock);
+        leader->stack_slots &= ~(1u << start.slot);
+        lock_release(&leader->process_lock);
+        return TID_ERROR;
+    }
+
+    /* Wait for the thread to set up its stack.  From then on its
+       babysitter belongs to the process rather than to us.  A
+       thread that failed has already exited and released its
+       slot. */
+    b = getChildBabySitter(tid);
+    sema_down(&b->sema_loading);
+    list_remove(&b->child_elem);
+    if (!b->load_success) {
+        thread_free_babysitter(b);
+        return TID_ERROR;
+    }
+    lock_acquire(&leader->process_lock);
+    list_push_back(&leader->threads, &b->child_elem);
+    lock_release(&leader->process_lock);
+    return tid;
+}
+
+/* Waits for thread TID of the current process to exit.  Returns
+   TID, or TID_ERROR if TID is not a thread of this process other
+   than its main thread and the caller, or has already been
+   joined. */
+tid_t process_pthread_join(tid_t tid) {
+    struct thread *cur = thread_current();
+    struct thread *leader = cur->leader;
+    struct babysitter *b = NULL;
+    struct list_elem *e;
+
+    if (tid == cur->tid) return TID_ERROR;
+
+    lock_acquire(&leader->process_lock);
+    for (e = list_begin(&leader->threads); e != list_end(&leader->threads); e = list_next(e)) {
+        struct babysitter *curr = list_entry(e, struct babysitter, child_elem);
+        if (curr->tid == tid) {
+            b = curr;
+            list_remove(e);
+            break;
+        }
+    }
+    lock_release(&leader->process_lock);
+    if (b == NULL) return TID_ERROR;
+
+    if (!sema_down_interruptible(&b->sema_loading)) {
+        /* The process is exiting.  Leave the thread for
+           join_all_threads(). */
+        lock_acquire(&leader->process_lock);
+        list_push_back(&leader->threads, &b->child_elem);
+        lock_release(&leader->process_lock);
+        return TID_ERROR;
+    }
+    thread_free_babysitter(b);
+    return tid;
+}
+
+/* Marks the current process as exiting and interrupts the
+   blocking waits of its other threads.  Each of them exits
+   before it would return to user mode. */
+void process_kill_threads(void) {
+    struct thread *leader = thread_current()->leader;
+    enum intr_level old_level;
+
+    leader->exiting = true;
+    old_level = intr_disable();
+    thread_foreach(interrupt_thread, leader);
+    intr_set_level(old_level);
+}
+
+/* Interrupts T if it is a thread of LEADER's process other than
+   the running thread. */
+static void interrupt_thread(struct thread *t, void *leader) {
+    if (t->leader == leader && t != thread_current()) sema_interrupt(t);
+}
+
+/* Exits the running thread if its process is exiting.  Called
+   whenever an interrupt, exception or system call is about to
+   return to user mode. */
+void process_check_exit(void) {
+    struct thread *cur = thread_current();
+
+    if (cur->leader != NULL && cur->leader->exiting) {
+        intr_enable();
+        thread_exit();
+    }
+}
+
+/* A thread function that joins the process of the thread that
+   created it and starts running user code on a new stack. */
+static void start_pthread(void *start_) {
+    struct pthread_start *start = start_;
+    struct thread *cur = thread_current();
+    struct intr_frame if_;
+    uint8_t *kpage;
+    void **esp;
+
+    cur->leader = start->leader;
+    cur->pagedir = start->leader->pagedir;
+    cur->stack_slot = start->slot;
+    process_activate();
+
+    /* Map the thread's stack. */
+    cur->user_stack = (uint8_t *)PHYS_BASE - start->slot * STACK_SPACING - PGSIZE;
+    kpage = palloc_get_page(PAL_USER | PAL_ZERO);
+    if (kpage == NULL || !install_page(cur->user_stack, kpage, true)) {
+        if (kpage != NULL) palloc_free_page(kpage);
+        cur->user_stack = NULL;
+        thread_exit();
+    }
+
+    /* Call STUB(FUN, ARG) with a null return address. */
+    esp = (void **)(cur->user_stack + PGSIZE);
+    *--esp = start->arg;
+    *--esp = start->fun;
+    *--esp = NULL;
+
+    memset(&if_, 0, sizeof if_);
+    if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+    if_.cs = SEL_UCSEG;
+    if_.eflags = FLAG_IF | FLAG_MBS;
+    if_.eip = (void (*)(void))start->stub;
+    if_.esp = esp;
+
+    cur->babysitter->load_success = true;
+    sema_up(&cur->babysitter->sema_loading);
+
+    asm volatile("movl %0, %%esp; jmp intr_exit" : : "g"(&if_) : "memory");
+    NOT_REACHED();
+}
+
+/* Frees the resources of the current thread, which is not the
+   main thread of its process.  A thread that started but did not
+   leave through pthread_exit() takes the rest of the process with
+   it. */
+static void pthread_exit_cleanup(void) {
+    struct thread *cur = thread_current();
+    struct thread *leader = cur->leader;
+
+    if (cur->babysitter->load_success && cur->babysitter->exit_code != 0)
+        process_kill_threads();
+
+    lock_acquire(&leader->process_lock);
+    if (cur->user_stack != NULL) {
+        palloc_free_page(pagedir_get_page(cur->pagedir, cur->user_stack));
+        pagedir_clear_page(cur->pagedir, cur->user_stack);
+    }
+    leader->stack_slots &= ~(1u << cur->stack_slot);
+    lock_release(&leader->process_lock);
+
+    while (!list_empty(&cur->children)) {
+        thread_free_babysitter(
+            list_entry(list_pop_front(&cur->children), struct babysitter, child_elem));
+    }
+
+    /* The page directory belongs to the main thread. */
+    cur->pagedir = NULL;
+    pagedir_activate(NULL);
+
+    sema_up(&cur->babysitter->sema_loading);
+}
+
+/* Waits for the other threads of the current process, which must
+   be its main thread, to exit.  If the main thread was killed,
+   they are stopped first. */
+static void join_all_threads(void) {
+    struct thread *cur = thread_current();
+
+    if (cur->babysitter->exit_code == -1) process_kill_threads();
+    lock_acquire(&cur->process_lock);
+    while (!list_empty(&cur->threads)) {
+        struct babysitter *b =
+            list_entry(list_pop_front(&cur->threads), struct babysitter, child_elem);
+        lock_release(&cur->process_lock);
+        sema_down(&b->sema_loading);
+        thread_free_babysitter(b);
+        lock_acquire(&cur->process_lock);
+    }
+    lock_release(&cur->process_lock);
+}
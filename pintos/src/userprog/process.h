@@ -2,13 +2,23 @@
 #define USERPROG_PROCESS_H
 
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 
 #define ARG_LIM 64
 
+/* Lowest address the heap may not grow past, leaving room below
+   PHYS_BASE for thread stacks and asynchronous I/O rings. */
+#define HEAP_LIMIT ((uint8_t *)PHYS_BASE - 8 * 1024 * 1024)
+
 tid_t process_execute(const char *file_name);
 int process_wait(tid_t);
 void process_exit(void);
 void process_activate(void);
+void *process_sbrk(intptr_t increment);
+tid_t process_pthread_create(void *stub, void *fun, void *arg);
+tid_t process_pthread_join(tid_t);
+void process_kill_threads(void);
+void process_check_exit(void);
 
 struct babysitter {
     struct list_elem child_elem;   /* Element to store ourselves in our parent
@@ -18,6 +28,7 @@ struct babysitter {
     int exit_code;
     bool load_success;
     struct file *file;
+    tid_t parent_tid; /* Process that created us. */
 };
 
 #endif /* userprog/process.h */
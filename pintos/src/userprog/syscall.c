@@ -3,41 +3,60 @@
 #include <stdio.h>
 #include <string.h>
 #include <syscall-nr.h>
+#include "devices/block.h"
 #include "devices/input.h"
+#include "devices/intq.h"
 #include "devices/shutdown.h"
+#include "devices/timer.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "kernel/list.h"
 #include "threads/interrupt.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
+#include "userprog/aio.h"
+#include "userprog/futex.h"
 #include "userprog/pagedir.h"
+#include "userprog/pipe.h"
 #include "userprog/process.h"
 
 struct lock io_lock;
 static struct list file_list;
+static struct kmem_cache *file_info_cache;
 int global_fd;
 
 struct file_info {
-    tid_t owner;
+    tid_t owner;  // tid of the owning process's main thread
     int fd;
     struct file *file;  // this holds the file
     struct list_elem elem;
     const char *file_name;  // this is the name of the file
+    struct pipe *pipe;      // or this holds one end of a pipe
+    bool pipe_writer;       // which is the write end if true
+    int ref_cnt;            // the fd itself plus each syscall using it
 };
 
 static void syscall_handler(struct intr_frame *);
+static void syscall_dispatch(struct intr_frame *, uint32_t *args);
+static void pipe_syscall(struct intr_frame *, uint32_t *args, struct file_info *);
 struct file_info *get_file(int fd);
 int add_fd(struct file *file, const char *file_name);
+static struct file_info *insert_fd(int fd);
+static void remove_fd(struct file_info *);
+static void put_fd(struct file_info *);
+static void file_syscall(struct intr_frame *, uint32_t *args, struct file_info *);
+static void bad_fd_buffer(struct file_info *) NO_RETURN;
 bool valid_pointer(void *ptr, size_t size);
+bool valid_buffer(const void *buffer, size_t size);
 
 struct file_info *get_file(int fd) {
     struct list_elem *e;
     for (e = list_begin(&file_list); e != list_end(&file_list); e = list_next(e)) {
         struct file_info *f = list_entry(e, struct file_info, elem);
-        if (f->fd == fd && f->owner == thread_current()->tid) {
+        if (f->fd == fd && f->owner == thread_current()->leader->tid) {
             return f;
         }
     }
@@ -45,26 +64,61 @@ struct file_info *get_file(int fd) {
 }
 
 int add_fd(struct file *file, const char *file_name) {
-    struct file_info *file_node = malloc(sizeof(struct file_info));
+    struct file_info *file_node = insert_fd(global_fd++);
     file_node->file = file;
     file_node->file_name = file_name;
-    file_node->fd = global_fd++;
-    file_node->owner = thread_current()->tid;
-    list_push_back(&file_list, &file_node->elem);
     return file_node->fd;
 }
 
+/* Adds an empty entry for the current process's FD to the file
+   list.  Fds 0 and 1 are only ever added to redirect the console,
+   which is counted so that console I/O can skip looking for them. */
+static struct file_info *insert_fd(int fd) {
+    struct file_info *file_node = kmem_cache_alloc(file_info_cache);
+    file_node->file = NULL;
+    file_node->file_name = NULL;
+    file_node->pipe = NULL;
+    file_node->pipe_writer = false;
+    file_node->ref_cnt = 1;
+    file_node->fd = fd;
+    file_node->owner = thread_current()->leader->tid;
+    list_push_back(&file_list, &file_node->elem);
+    if (fd == 0 || fd == 1) thread_current()->leader->std_redirects++;
+    return file_node;
+}
+
+/* Takes FILE_NODE out of the file list.  Its file or pipe end is
+   closed once no other thread is still using it.  io_lock must be
+   held. */
+static void remove_fd(struct file_info *file_node) {
+    if (file_node->fd == 0 || file_node->fd == 1) thread_current()->leader->std_redirects--;
+    list_remove(&file_node->elem);
+    put_fd(file_node);
+}
+
+/* Drops a reference to FILE_NODE.  The last one closes its file
+   or pipe end and frees it.  io_lock must be held. */
+static void put_fd(struct file_info *file_node) {
+    ASSERT(file_node->ref_cnt > 0);
+    if (--file_node->ref_cnt > 0) return;
+    if (file_node->pipe != NULL)
+        pipe_close(file_node->pipe, file_node->pipe_writer);
+    else
+        file_close(file_node->file);
+    kmem_cache_free(file_info_cache, file_node);
+}
+
 void close_all_files(tid_t tid) {
-    struct list_elem *e = list_begin(&file_list);
+    struct list_elem *e;
+
+    lock_acquire(&io_lock);
+    e = list_begin(&file_list);
     while (e != list_end(&file_list)) {
         struct file_info *f = list_entry(e, struct file_info, elem);
         e = list_next(e);
-        if (f->owner == tid) {
-            file_close(f->file);
-            list_remove(&f->elem);
-            free(f);
-        }
+        if (f->owner == tid) remove_fd(f);
     }
+    lock_release(&io_lock);
 }
 
 bool valid_pointer(void *ptr, size_t size) {
@@ -78,20 +132,90 @@ bool valid_pointer(void *ptr, size_t size) {
     return true;
 }
 
+/* Returns true if every byte of the SIZE-byte BUFFER is mapped
+   user memory. */
+bool valid_buffer(const void *buffer, size_t size) {
+    const uint8_t *start = buffer;
+    const uint8_t *page;
+
+    if (size == 0) return true;
+    if (start + size < start || !is_user_vaddr(start + size - 1)) return false;
+    for (page = pg_round_down(start); page < start + size; page += PGSIZE) {
+        if (pagedir_get_page(thread_current()->pagedir, page) == NULL) return false;
+    }
+    return true;
+}
+
+/* Gives the current process its own copy of each pipe end that
+   process PARENT has open, under the same fd.  Ordinary files are not
+   inherited. */
+void syscall_inherit_fds(tid_t parent) {
+    struct list_elem *e;
+
+    lock_acquire(&io_lock);
+    for (e = list_begin(&file_list); e != list_end(&file_list); e = list_next(e)) {
+        struct file_info *f = list_entry(e, struct file_info, elem);
+        if (f->owner == parent && f->pipe != NULL) {
+            struct file_info *copy = insert_fd(f->fd);
+            pipe_open(f->pipe, f->pipe_writer);
+            copy->pipe = f->pipe;
+            copy->pipe_writer = f->pipe_writer;
+        }
+    }
+    lock_release(&io_lock);
+}
+
+/* Returns a new file for the same inode as the current process's
+   ordinary file FD, or a null pointer if FD is not open, is not a
+   file, or is a directory. */
+struct file *syscall_reopen_fd(int fd) {
+    struct file_info *f;
+    struct file *file = NULL;
+
+    lock_acquire(&io_lock);
+    f = get_file(fd);
+    if (f != NULL && f->pipe == NULL && !file_isdir(f->file)) file = file_reopen(f->file);
+    lock_release(&io_lock);
+    return file;
+}
+
 void syscall_init(void) {
     global_fd = 2;
     list_init(&file_list);
-    lock_init(&io_lock);
+    file_info_cache = kmem_cache_create("file_info", sizeof(struct file_info), NULL);
+    if (file_info_cache == NULL) PANIC("file_info cache creation failed");
+    lock_init_named(&io_lock, "io");
+    futex_init();
+    aio_init();
     intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
-static void syscall_handler(struct intr_frame *f UNUSED) {
+static void syscall_handler(struct intr_frame *f) {
     uint32_t *args = ((uint32_t *)f->esp);
+    uint32_t number;
 
     if (!valid_pointer(args, sizeof(uint32_t))) {
         thread_exit();
     }
+    thread_current()->syscall_cnt++;
+
+    /* Another thread has ended the process. */
+    if (thread_current()->leader->exiting) {
+        thread_exit();
+    }
+
+    number = args[0];
+    if (trace_enabled) {
+        bool have_args = valid_pointer(args, 3 * sizeof(uint32_t));
+        TRACE(SYSCALL, number, have_args ? args[1] : 0, have_args ? args[2] : 0);
+    }
+    syscall_dispatch(f, args);
+    TRACE(SYSCALL_RETURN, number, f->eax, 0);
+}
 
+/* Carries out the system call whose number and arguments are at
+   ARGS, the user stack pointer of F, which must be valid. */
+static void syscall_dispatch(struct intr_frame *f, uint32_t *args) {
     /* -----------PROCESS SYSCALLS----------- */
 
     /* int practice(int i) */
@@ -109,7 +233,8 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
 
     /* void exit (int status)  */
     if (args[0] == SYS_EXIT) {
-        thread_current()->babysitter->exit_code = args[1];
+        thread_current()->leader->babysitter->exit_code = args[1];
+        process_kill_threads();
         f->eax = args[1];
         thread_exit();
     }
@@ -131,6 +256,162 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
         return;
     }
 
+    /* void *sbrk(intptr_t increment) */
+    if (args[0] == SYS_SBRK) {
+        f->eax = (uint32_t)process_sbrk((intptr_t)args[1]);
+        return;
+    }
+
+    /* int pipe(int fds[2]) */
+    if (args[0] == SYS_PIPE) {
+        int *fds = (int *)args[1];
+        struct pipe *p;
+        if (!valid_buffer(fds, 2 * sizeof *fds)) {
+            thread_exit();
+        }
+        p = pipe_create();
+        if (p == NULL) {
+            f->eax = -1;
+            return;
+        }
+        lock_acquire(&io_lock);
+        struct file_info *reader = insert_fd(global_fd++);
+        struct file_info *writer = insert_fd(global_fd++);
+        reader->pipe = writer->pipe = p;
+        writer->pipe_writer = true;
+        lock_release(&io_lock);
+        fds[0] = reader->fd;
+        fds[1] = writer->fd;
+        f->eax = 0;
+        return;
+    }
+
+    /* int dup2(int old_fd, int new_fd)
+       Only stdin and stdout can be redirected, and closing them
+       afterward goes back to the console. */
+    if (args[0] == SYS_DUP2) {
+        int new_fd = (int)args[2];
+        struct file_info *old, *dup, *prev;
+        f->eax = -1;
+        if (new_fd != 0 && new_fd != 1) return;
+        lock_acquire(&io_lock);
+        old = get_file((int)args[1]);
+        if (old != NULL && old->fd != new_fd) {
+            struct file *file = old->pipe != NULL ? NULL : file_reopen(old->file);
+            if (old->pipe != NULL || file != NULL) {
+                prev = get_file(new_fd);
+                if (prev != NULL) remove_fd(prev);
+                dup = insert_fd(new_fd);
+                dup->file = file;
+                dup->file_name = old->file_name;
+                dup->pipe = old->pipe;
+                dup->pipe_writer = old->pipe_writer;
+                if (dup->pipe != NULL) pipe_open(dup->pipe, dup->pipe_writer);
+                f->eax = new_fd;
+            }
+        } else if (old != NULL) {
+            f->eax = new_fd;
+        }
+        lock_release(&io_lock);
+        return;
+    }
+
+    /* -----------THREAD SYSCALLS----------- */
+
+    /* tid_t sys_pthread_create(stub_fun sfun, pthread_fun tfun, const void *arg) */
+    if (args[0] == SYS_PT_CREATE) {
+        if (!valid_buffer(args, 4 * sizeof *args)) {
+            thread_exit();
+        }
+        f->eax = process_pthread_create((void *)args[1], (void *)args[2], (void *)args[3]);
+        return;
+    }
+
+    /* void sys_pthread_exit(void)
+       In the main thread, the process exits with status 0 once
+       every other thread has exited. */
+    if (args[0] == SYS_PT_EXIT) {
+        thread_current()->babysitter->exit_code = 0;
+        thread_exit();
+    }
+
+    /* tid_t sys_pthread_join(tid_t tid) */
+    if (args[0] == SYS_PT_JOIN) {
+        f->eax = process_pthread_join((tid_t)args[1]);
+        return;
+    }
+
+    /* tid_t get_tid(void) */
+    if (args[0] == SYS_GET_TID) {
+        f->eax = thread_current()->tid;
+        return;
+    }
+
+    /* int futex_wait(const int *addr, int val)
+       int futex_wake(const int *addr, int cnt) */
+    if (args[0] == SYS_FUTEX_WAIT || args[0] == SYS_FUTEX_WAKE) {
+        const int *addr = (const int *)args[1];
+        if (!valid_buffer(args, 3 * sizeof *args) || !valid_buffer(addr, sizeof *addr)) {
+            thread_exit();
+        }
+        if ((uintptr_t)addr % sizeof *addr != 0)
+            f->eax = -1;
+        else if (args[0] == SYS_FUTEX_WAIT)
+            f->eax = futex_wait(addr, (int)args[2]);
+        else
+            f->eax = futex_wake(addr, (int)args[2]);
+        return;
+    }
+
+    /* -----------ASYNCHRONOUS I/O SYSCALLS----------- */
+
+    /* struct aio_ring *aio_setup(void) */
+    if (args[0] == SYS_AIO_SETUP) {
+        f->eax = (uint32_t)aio_setup();
+        return;
+    }
+
+    /* int aio_enter(unsigned to_submit, unsigned min_complete) */
+    if (args[0] == SYS_AIO_ENTER) {
+        if (!valid_buffer(args, 3 * sizeof *args)) {
+            thread_exit();
+        }
+        f->eax = aio_enter(args[1], args[2]);
+        return;
+    }
+
+    /* void clock_ns(int64_t *ns)
+       The user wrapper returns *NS, nanoseconds since boot. */
+    if (args[0] == SYS_CLOCK_NS) {
+        int64_t *ns = (int64_t *)args[1];
+        if (!valid_buffer(args, 2 * sizeof *args) || !valid_buffer(ns, sizeof *ns)) {
+            thread_exit();
+        }
+        *ns = timer_ns();
+        return;
+    }
+
+    /* void block_stats(unsigned long long *read_cnt, unsigned long long *write_cnt)
+       Sectors read from and written to the file system device. */
+    if (args[0] == SYS_BLOCK_STATS) {
+        unsigned long long *read_cnt = (unsigned long long *)args[1];
+        unsigned long long *write_cnt = (unsigned long long *)args[2];
+        if (!valid_buffer(args, 3 * sizeof *args) || !valid_buffer(read_cnt, sizeof *read_cnt) ||
+            !valid_buffer(write_cnt, sizeof *write_cnt)) {
+            thread_exit();
+        }
+        *read_cnt = block_read_cnt(fs_device);
+        *write_cnt = block_write_cnt(fs_device);
+        return;
+    }
+
+    /* void sched_dump(void) */
+    if (args[0] == SYS_SCHED_DUMP) {
+        thread_print_accounting();
+        trace_print_sched();
+        return;
+    }
+
     /* -----------DIRECTORY SYSCALLS----------- */
 
     /* bool chdir(const char *dir) */
@@ -144,11 +425,11 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
     }
     /* bool mkdir(const char *dir) */
     if (args[0] == SYS_MKDIR) {
-        lock_acquire(&io_lock);
         const char *dir = (const char *)args[1];
         if (!valid_pointer((void *)dir, sizeof(char *))) {
             thread_exit();
         }
+        lock_acquire(&io_lock);
         f->eax = filesys_create(dir, 0, true);
         lock_release(&io_lock);
         return;
@@ -158,12 +439,12 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
 
     /* bool create(const char *file, unsigned initial_size) */
     if (args[0] == SYS_CREATE) {
-        lock_acquire(&io_lock);
         const char *file_name = (const char *)args[1];
         unsigned size = (unsigned)args[2];
         if (!valid_pointer((void *)file_name, sizeof(char *))) {
             thread_exit();
         }
+        lock_acquire(&io_lock);
         f->eax = filesys_create(file_name, size, false);
         lock_release(&io_lock);
         return;
@@ -171,11 +452,11 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
 
     /* bool remove(const char *file) */
     if (args[0] == SYS_REMOVE) {
-        lock_acquire(&io_lock);
         const char *file_name = (const char *)args[1];
         if (!valid_pointer((void *)file_name, sizeof(char *))) {
             thread_exit();
         }
+        lock_acquire(&io_lock);
         f->eax = filesys_remove(file_name);
         lock_release(&io_lock);
         return;
@@ -183,74 +464,61 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
 
     /* int open(const char *file) */
     if (args[0] == SYS_OPEN) {
-        // lock_acquire(&io_lock);
-
         const char *file_name = (const char *)args[1];
         if (!valid_pointer((void *)file_name, sizeof(char *))) {
             thread_exit();
         }
 
+        lock_acquire(&io_lock);
         struct file *file = filesys_open(file_name);
         if (file == NULL) {
             f->eax = -1;
         } else {
             f->eax = add_fd(file, file_name);
         }
-
-        // lock_release(&io_lock);
+        lock_release(&io_lock);
         return;
     }
 
     /* Write to standard output */
-    if (args[0] == SYS_WRITE) {
-        lock_acquire(&io_lock);
-        int fd = (int)args[1];
+    if (args[0] == SYS_WRITE && (int)args[1] == 1 &&
+        thread_current()->leader->std_redirects == 0) {
+        /* The console lock in putbuf() keeps the whole buffer
+           together, so there is no need for io_lock. */
         char *buffer = (char *)args[2];
-        if (!valid_pointer(buffer, sizeof(char *))) {
+        unsigned size = (unsigned)args[3];
+        if (!valid_buffer(buffer, size)) {
             thread_exit();
         }
-        int size = (int)args[3];
-        if (fd == 1) {
-            while (size >= 100) {
-                putbuf(buffer, 100);
-                buffer += 100;
-                size -= 100;
-            }
-            putbuf(buffer, size);
-            f->eax = (int)args[3];
-            lock_release(&io_lock);
-            return;
-        }
-        lock_release(&io_lock);
+        putbuf(buffer, size);
+        f->eax = size;
+        return;
     }
 
-    /* Read from standard input */
-    if (args[0] == SYS_READ) {
-        lock_acquire(&io_lock);
-        int fd = (int)args[1];
+    /* Read from standard input.  Only this thread waits for a key,
+       without io_lock, and then it takes every key that has arrived
+       up to the end of the line, like a terminal, in one go. */
+    if (args[0] == SYS_READ && (int)args[1] == 0 &&
+        thread_current()->leader->std_redirects == 0) {
         uint8_t *buffer = (uint8_t *)args[2];
-        if (!valid_pointer(buffer, sizeof(char *))) {
-            thread_exit();
-        }
         unsigned size = (unsigned)args[3];
-        if (fd == 0) {
-            size_t count = 0;
-            while (count < size) {
-                buffer[count] = input_getc();
-                if (buffer[count] == '\n') {
-                    break;
-                }
-                count++;
-            }
-            f->eax = count;
-            lock_release(&io_lock);
-            return;
+        uint8_t keys[INTQ_BUFSIZE];
+        size_t cnt;
+        if (!valid_buffer(buffer, size)) {
+            thread_exit();
         }
-        lock_release(&io_lock);
+        cnt = input_getbuf(keys, size < sizeof keys ? size : sizeof keys);
+        memcpy(buffer, keys, cnt);
+        f->eax = cnt;
+        return;
     }
 
+    /* Every other syscall names an fd.  Hold a reference to its
+       entry, so that another thread closing the fd meanwhile does not
+       free it under us. */
     lock_acquire(&io_lock);
     struct file_info *file_node = get_file(args[1]);
+    if (file_node != NULL) file_node->ref_cnt++;
     lock_release(&io_lock);
 
     if (file_node == NULL) {
@@ -258,6 +526,28 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
         return;
     }
 
+    if (file_node->pipe != NULL)
+        pipe_syscall(f, args, file_node);
+    else
+        file_syscall(f, args, file_node);
+
+    lock_acquire(&io_lock);
+    put_fd(file_node);
+    lock_release(&io_lock);
+}
+
+/* Exits the thread for passing a bad buffer to a syscall on
+   FILE_NODE, after dropping the reference to it. */
+static void bad_fd_buffer(struct file_info *file_node) {
+    lock_acquire(&io_lock);
+    put_fd(file_node);
+    lock_release(&io_lock);
+    thread_exit();
+}
+
+/* Carries out a file syscall on FILE_NODE, which holds an ordinary
+   file or directory. */
+static void file_syscall(struct intr_frame *f, uint32_t *args, struct file_info *file_node) {
     /* int filesize(int fd) */
     if (args[0] == SYS_FILESIZE) {
         lock_acquire(&io_lock);
@@ -268,11 +558,9 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
 
     /* int read(int fd, void *buffer, unsigned size) */
     if (args[0] == SYS_READ) {
-        lock_acquire(&io_lock);
         void *buffer = (void *)args[2];
-        if (!valid_pointer(buffer, sizeof(char *))) {
-            thread_exit();
-        }
+        if (!valid_pointer(buffer, sizeof(char *))) bad_fd_buffer(file_node);
+        lock_acquire(&io_lock);
         unsigned size = (unsigned)args[3];
         if (file_isdir(file_node->file)) {
             f->eax = -1;
@@ -285,11 +573,9 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
 
     /* int write(int fd, const void *buffer, unsigned size) */
     if (args[0] == SYS_WRITE) {
-        lock_acquire(&io_lock);
         void *buffer = (void *)args[2];
-        if (!valid_pointer(buffer, sizeof(char *))) {
-            thread_exit();
-        }
+        if (!valid_pointer(buffer, sizeof(char *))) bad_fd_buffer(file_node);
+        lock_acquire(&io_lock);
         unsigned size = (unsigned)args[3];
         if (file_isdir(file_node->file)) {
             f->eax = -1;
@@ -316,12 +602,11 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
         return;
     }
 
-    /* void close(int fd) */
+    /* void close(int fd)
+       Another thread may have closed the fd since we looked it up. */
     if (args[0] == SYS_CLOSE) {
         lock_acquire(&io_lock);
-        file_close(file_node->file);
-        list_remove(&file_node->elem);
-        free(file_node);
+        if (get_file(file_node->fd) == file_node) remove_fd(file_node);
         lock_release(&io_lock);
         return;
     }
@@ -349,3 +634,40 @@ static void syscall_handler(struct intr_frame *f UNUSED) {
         return;
     }
 }
+
+/* Carries out a file syscall on FILE_NODE, which holds one end of
+   a pipe.  Reads and writes may sleep, so they run without
+   io_lock. */
+static void pipe_syscall(struct intr_frame *f, uint32_t *args, struct file_info *file_node) {
+    void *buffer = (void *)args[2];
+    unsigned size = (unsigned)args[3];
+
+    switch (args[0]) {
+    case SYS_READ:
+        if (!valid_buffer(buffer, size)) bad_fd_buffer(file_node);
+        f->eax = file_node->pipe_writer ? -1 : pipe_read(file_node->pipe, buffer, size);
+        break;
+
+    case SYS_WRITE:
+        if (!valid_buffer(buffer, size)) bad_fd_buffer(file_node);
+        f->eax = file_node->pipe_writer ? pipe_write(file_node->pipe, buffer, size) : -1;
+        break;
+
+    case SYS_CLOSE:
+        lock_acquire(&io_lock);
+        if (get_file(file_node->fd) == file_node) remove_fd(file_node);
+        lock_release(&io_lock);
+        break;
+
+    case SYS_ISDIR:
+        f->eax = false;
+        break;
+
+    case SYS_SEEK:
+        break;
+
+    default:
+        f->eax = -1;
+        break;
+    }
+}
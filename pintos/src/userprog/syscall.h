@@ -1,8 +1,16 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
+#include "threads/synch.h"
 #include "threads/thread.h"
 
+/* Serializes file system access. */
+extern struct lock io_lock;
+
+struct file;
+
 void syscall_init(void);
 void close_all_files(tid_t tid);
+void syscall_inherit_fds(tid_t parent);
+struct file *syscall_reopen_fd(int fd);
 
 #endif /* userprog/syscall.h */